@@ -0,0 +1,73 @@
+/*
+ ==============================================================================
+
+ Contiguous, cache-line-aligned storage for the stereo chains' coefficients and states.
+
+ ==============================================================================
+ */
+
+#include "ChainArena.h"
+
+void ChainArena::allocate(int newNumChannels)
+{
+    jassert(newNumChannels > 0 && newNumChannels <= maxChannels);
+
+    if (newNumChannels != numChannels)
+    {
+        // HeapBlock only guarantees malloc's alignment, so over-allocate and round the start up to a cache line
+        auto numBytes = (size_t) (newNumChannels * channelStride) * sizeof(Stage);
+        storage.allocate(numBytes + cacheLineSize - 1, false);
+
+        auto address = reinterpret_cast<std::uintptr_t>(storage.get());
+        stages = reinterpret_cast<Stage*>((address + cacheLineSize - 1) & ~(std::uintptr_t) (cacheLineSize - 1));
+        numChannels = newNumChannels;
+    }
+
+    for (int i = 0; i < numChannels * channelStride; ++i)
+        new (stages + i) Stage();
+}
+
+void ChainArena::reset() noexcept
+{
+    for (int i = 0; i < numChannels * channelStride; ++i)
+    {
+        stages[i].state[0] = 0.f;
+        stages[i].state[1] = 0.f;
+    }
+}
+
+void ChainArena::process(int channel, float* samples, int numSamples, int firstStage, int endStage) noexcept
+{
+    jassert(juce::isPositiveAndBelow(channel, numChannels));
+    jassert(firstStage >= 0 && endStage <= maxStages);
+
+    auto* channelStages = getStages(channel);
+
+    for (int index = firstStage; index < endStage; ++index)
+    {
+        auto& stage = channelStages[index];
+
+        if (stage.active == 0)
+            continue;
+
+        // everything in registers for the loop, like IIR::Filter::processInternal()
+        const auto b0 = stage.coefficients[0], b1 = stage.coefficients[1], b2 = stage.coefficients[2];
+        const auto a1 = stage.coefficients[3], a2 = stage.coefficients[4];
+        auto s0 = stage.state[0];
+        auto s1 = stage.state[1];
+
+        for (int n = 0; n < numSamples; ++n)
+        {
+            auto x = samples[n];
+            auto y = b0 * x + s0;
+            s0 = b1 * x - a1 * y + s1;
+            s1 = b2 * x - a2 * y;
+            samples[n] = y;
+        }
+
+        juce::dsp::util::snapToZero(s0);
+        juce::dsp::util::snapToZero(s1);
+        stage.state[0] = s0;
+        stage.state[1] = s1;
+    }
+}
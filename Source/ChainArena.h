@@ -0,0 +1,80 @@
+/*
+ ==============================================================================
+
+ Contiguous, cache-line-aligned storage for the stereo chains' coefficients and states.
+
+ ==============================================================================
+ */
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/*
+ Every IIR::Filter in a MonoChain points to its own heap-allocated Coefficients object (which in turn
+ owns a heap-allocated array), and keeps its state in another heap array. Running the 9 stages of both
+ chains means following around 50 pointers into memory that's scattered all over the heap. With one
+ instance that stays in cache, but with hundreds of instances each processBlock() starts cold and pays
+ a cache miss for most of them.
+
+ The arena keeps everything the stereo chains need while processing in one block, allocated in
+ prepareToPlay() and aligned to a cache line:
+
+     channel 0: | stage 0 | stage 1 | ... | stage 8 | pad |   each stage: b0 b1 b2 a1 a2, 2 states, flag
+     channel 1: | stage 0 | stage 1 | ... | stage 8 | pad |   (32 bytes, two per cache line)
+
+ So a block touches 10 consecutive cache lines and nothing else. updateFilters() designs the coefficients
+ straight into the stages (see the ChainArena overloads of updateCoefficients() and updateCutFilter() in
+ PluginProcessor.h), so there's nothing to copy over from the chains before a block either.
+ */
+class ChainArena
+{
+    public:
+    static constexpr int maxChannels = 2;
+
+    // LowCut (4) + Peak (1) + HighCut (4)
+    static constexpr int maxStages = 9;
+
+    // stages 0-3 are the LowCut, 4 the Peak, 5-8 the HighCut
+    static constexpr int firstLowCutStage = 0;
+    static constexpr int peakStage = 4;
+    static constexpr int firstHighCutStage = 5;
+
+    static constexpr size_t cacheLineSize = 64;
+
+    // Allocates (or reuses) the storage and clears it. Not realtime safe: call it from prepareToPlay().
+    void allocate(int numChannels);
+
+    void reset() noexcept;
+
+    int getNumChannels() const noexcept { return numChannels; }
+
+    struct Stage
+    {
+        float coefficients[5] { 1.f, 0.f, 0.f, 0.f, 0.f }; // b0, b1, b2, a1, a2
+        float state[2] { 0.f, 0.f };
+        juce::uint32 active { 0 };
+    };
+
+    static_assert(sizeof(Stage) == 32, "two stages per cache line");
+
+    Stage& getStage(int channel, int index) noexcept
+    {
+        jassert(juce::isPositiveAndBelow(channel, numChannels) && juce::isPositiveAndBelow(index, maxStages));
+        return getStages(channel)[index];
+    }
+
+    // The same transposed direct form II recursion as IIR::Filter, in place, through stages
+    // [firstStage, endStage). Running a range lets something else go in between (see FeedbackSuppressor).
+    void process(int channel, float* samples, int numSamples, int firstStage = 0, int endStage = maxStages) noexcept;
+
+    private:
+    // each channel starts on its own cache line
+    static constexpr int channelStride = (int) ((maxStages * sizeof(Stage) + cacheLineSize - 1) / cacheLineSize * cacheLineSize / sizeof(Stage));
+
+    juce::HeapBlock<char> storage;
+    Stage* stages = nullptr;
+    int numChannels = 0;
+
+    Stage* getStages(int channel) const noexcept { return stages + channel * channelStride; }
+};
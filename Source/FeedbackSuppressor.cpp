@@ -0,0 +1,284 @@
+/*
+ ==============================================================================
+
+ Automatic feedback (howl) detection and suppression with a pool of notches.
+
+ ==============================================================================
+ */
+
+#include "FeedbackSuppressor.h"
+#include "MatchedFilterDesign.h"
+
+void FeedbackSuppressor::prepare(double newSampleRate)
+{
+    sampleRate = newSampleRate;
+
+    auto topFrequency = juce::jmin(highestFrequency, 0.45 * sampleRate);
+    auto numBins = 1 + (int) std::floor(binsPerOctave * std::log2(topFrequency / lowestFrequency));
+
+    auto numRegisters = ((size_t) numBins + binsPerRegister - 1) / binsPerRegister;
+
+    binFrequencies.resize((size_t) numBins);
+    binNormalisation.resize((size_t) numBins);
+    binDecibels.resize((size_t) numBins);
+    binPersistence.resize((size_t) numBins);
+
+    binCos.assign(numRegisters, Register::expand(0.f));
+    binSin.assign(numRegisters, Register::expand(0.f));
+    binReal.resize(numRegisters);
+    binImag.resize(numRegisters);
+
+    // filled per bin here, then loaded into the registers
+    std::vector<float> cosines(numRegisters * binsPerRegister, 0.f), sines(numRegisters * binsPerRegister, 0.f);
+
+    // bandwidth of each bin: the 1/12 octave around its centre
+    auto relativeBandwidth = std::pow(2.0, 0.5 / binsPerOctave) - std::pow(2.0, -0.5 / binsPerOctave);
+
+    for (size_t k = 0; k < (size_t) numBins; ++k)
+    {
+        auto frequency = lowestFrequency * std::pow(2.0, (double) k / binsPerOctave);
+        auto w = juce::MathConstants<double>::twoPi * frequency / sampleRate;
+        auto r = std::exp(-juce::MathConstants<double>::pi * relativeBandwidth * frequency / sampleRate);
+
+        binFrequencies[k] = frequency;
+        cosines[k] = (float) (r * std::cos(w));
+        sines[k] = (float) (r * std::sin(w));
+        binNormalisation[k] = (float) (2.0 * (1.0 - r));
+    }
+
+    alignas(Register::SIMDRegisterSize) float lanes[binsPerRegister];
+
+    for (size_t i = 0; i < numRegisters; ++i)
+    {
+        std::copy_n(cosines.data() + i * binsPerRegister, binsPerRegister, lanes);
+        binCos[i] = Register::fromRawArray(lanes);
+
+        std::copy_n(sines.data() + i * binsPerRegister, binsPerRegister, lanes);
+        binSin[i] = Register::fromRawArray(lanes);
+    }
+
+    hopLength = juce::jmax(1, juce::roundToInt(hopSeconds * sampleRate));
+    persistenceHops = juce::jmax(1, juce::roundToInt(persistenceSeconds / hopSeconds));
+    holdHopsAfterTrigger = juce::jmax(1, juce::roundToInt(holdSeconds / hopSeconds));
+    releaseDecibelsPerHop = (float) (releaseDecibelsPerSecond * hopSeconds);
+
+    reset();
+}
+
+void FeedbackSuppressor::reset() noexcept
+{
+    for (auto& notch : notches)
+        notch = Notch();
+
+    std::fill(binReal.begin(), binReal.end(), Register::expand(0.f));
+    std::fill(binImag.begin(), binImag.end(), Register::expand(0.f));
+    std::fill(binDecibels.begin(), binDecibels.end(), -200.f);
+    std::fill(binPersistence.begin(), binPersistence.end(), 0);
+
+    samplesUntilHop = hopLength;
+}
+
+int FeedbackSuppressor::getNumActiveNotches() const noexcept
+{
+    return (int) std::count_if(notches.begin(), notches.end(), [](const Notch& notch) { return notch.active; });
+}
+
+void FeedbackSuppressor::processNotches(int channel, float* samples, int numSamples) noexcept
+{
+    jassert(juce::isPositiveAndBelow(channel, maxChannels));
+
+    for (auto& notch : notches)
+    {
+        if (! notch.active)
+            continue;
+
+        const auto b0 = notch.coefficients[0], b1 = notch.coefficients[1], b2 = notch.coefficients[2];
+        const auto a1 = notch.coefficients[3], a2 = notch.coefficients[4];
+        auto s0 = notch.state[channel][0];
+        auto s1 = notch.state[channel][1];
+
+        for (int n = 0; n < numSamples; ++n)
+        {
+            auto x = samples[n];
+            auto y = b0 * x + s0;
+            s0 = b1 * x - a1 * y + s1;
+            s1 = b2 * x - a2 * y;
+            samples[n] = y;
+        }
+
+        juce::dsp::util::snapToZero(s0);
+        juce::dsp::util::snapToZero(s1);
+        notch.state[channel][0] = s0;
+        notch.state[channel][1] = s1;
+    }
+}
+
+void FeedbackSuppressor::analyse(const float* const* channels, int numChannels, int numSamples) noexcept
+{
+    if (binFrequencies.empty() || numChannels <= 0)
+        return;
+
+    int position = 0;
+
+    // run the bins up to each hop boundary, then evaluate them
+    while (position < numSamples)
+    {
+        auto chunk = juce::jmin(samplesUntilHop, numSamples - position);
+        updateBins(channels, juce::jmin(numChannels, maxChannels), position, chunk);
+
+        position += chunk;
+        samplesUntilHop -= chunk;
+
+        if (samplesUntilHop == 0)
+        {
+            runHop();
+            samplesUntilHop = hopLength;
+        }
+    }
+}
+
+void FeedbackSuppressor::updateBins(const float* const* channels, int numChannels, int startSample, int numSamples) noexcept
+{
+    auto numRegisters = binReal.size();
+    const auto* c = binCos.data();
+    const auto* s = binSin.data();
+    auto* re = binReal.data();
+    auto* im = binImag.data();
+    auto channelGain = 1.f / (float) numChannels;
+
+    for (int n = startSample; n < startSample + numSamples; ++n)
+    {
+        // feedback is in the room, so both channels carry it: listen to their sum
+        auto x = 0.f;
+
+        for (int channel = 0; channel < numChannels; ++channel)
+            x += channels[channel][n];
+
+        auto input = Register::expand(x * channelGain);
+
+        for (size_t i = 0; i < numRegisters; ++i)
+        {
+            auto newRe = c[i] * re[i] - s[i] * im[i] + input;
+            auto newIm = s[i] * re[i] + c[i] * im[i];
+            re[i] = newRe;
+            im[i] = newIm;
+        }
+    }
+}
+
+void FeedbackSuppressor::runHop() noexcept
+{
+    auto numBins = binFrequencies.size();
+    auto averageDecibels = 0.f;
+
+    for (size_t k = 0; k < numBins; ++k)
+    {
+        auto re = binReal[k / binsPerRegister].get(k % binsPerRegister);
+        auto im = binImag[k / binsPerRegister].get(k % binsPerRegister);
+        auto amplitude = binNormalisation[k] * std::sqrt(re * re + im * im);
+        binDecibels[k] = juce::Decibels::gainToDecibels(amplitude, -200.f);
+        averageDecibels += binDecibels[k];
+    }
+
+    averageDecibels /= (float) numBins;
+
+    for (size_t k = 1; k + 1 < numBins; ++k)
+    {
+        auto level = binDecibels[k];
+
+        auto isCandidate = level > thresholdDecibels
+                           && level >= binDecibels[k - 1] && level >= binDecibels[k + 1]
+                           && level - averageDecibels > peakToAverageDecibels;
+
+        if (! isCandidate)
+        {
+            binPersistence[k] = 0;
+            continue;
+        }
+
+        if (++binPersistence[k] < persistenceHops)
+            continue;
+
+        binPersistence[k] = 0;
+
+        // Fit a parabola through the three bins' levels to find the peak between them.
+        // The bins are evenly spaced in log frequency, so the offset is in bins, i.e. 1/12 octaves.
+        auto left = binDecibels[k - 1], right = binDecibels[k + 1];
+        auto denominator = left - 2.f * level + right;
+        auto offset = denominator < 0.f ? juce::jlimit(-0.5f, 0.5f, 0.5f * (left - right) / denominator) : 0.f;
+
+        trigger(binFrequencies[k] * std::pow(2.0, (double) offset / binsPerOctave));
+    }
+
+    // hold, then release
+    for (auto& notch : notches)
+    {
+        if (! notch.active)
+            continue;
+
+        if (notch.holdHops > 0)
+        {
+            --notch.holdHops;
+            continue;
+        }
+
+        notch.depthDecibels -= releaseDecibelsPerHop;
+
+        if (notch.depthDecibels <= 0.f)
+            notch.active = false;
+        else
+            updateNotchCoefficients(notch);
+    }
+}
+
+void FeedbackSuppressor::trigger(double frequency) noexcept
+{
+    // a notch already within half a bin of this frequency is the same howl: it wasn't deep enough
+    for (auto& notch : notches)
+    {
+        if (notch.active && std::abs(std::log2(frequency / notch.frequency)) < 0.5 / binsPerOctave)
+        {
+            notch.frequency = 0.5 * (notch.frequency + frequency);
+            notch.depthDecibels = juce::jmin(maxDepthDecibels, notch.depthDecibels + depthStepDecibels);
+            notch.holdHops = holdHopsAfterTrigger;
+            updateNotchCoefficients(notch);
+            return;
+        }
+    }
+
+    // otherwise take a free notch, or the one that has been quiet the longest
+    auto* target = &notches[0];
+
+    for (auto& notch : notches)
+    {
+        if (! notch.active)
+        {
+            target = &notch;
+            break;
+        }
+
+        if (notch.holdHops < target->holdHops)
+            target = &notch;
+    }
+
+    *target = Notch();
+    target->active = true;
+    target->frequency = frequency;
+    target->depthDecibels = firstDepthDecibels;
+    target->holdHops = holdHopsAfterTrigger;
+    updateNotchCoefficients(*target);
+}
+
+void FeedbackSuppressor::updateNotchCoefficients(Notch& notch) noexcept
+{
+    // a narrow peak cut. The matched design keeps it narrow close to Nyquist, and doesn't allocate.
+    auto section = MatchedFilterDesign::makePeakFilter(sampleRate, notch.frequency, notchQ,
+                                                       juce::Decibels::decibelsToGain((double) -notch.depthDecibels));
+
+    auto a0 = section[3];
+    notch.coefficients[0] = (float) (section[0] / a0);
+    notch.coefficients[1] = (float) (section[1] / a0);
+    notch.coefficients[2] = (float) (section[2] / a0);
+    notch.coefficients[3] = (float) (section[4] / a0);
+    notch.coefficients[4] = (float) (section[5] / a0);
+}
@@ -0,0 +1,106 @@
+/*
+ ==============================================================================
+
+ Automatic feedback (howl) detection and suppression with a pool of notches.
+
+ ==============================================================================
+ */
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/*
+ Feedback shows up as a single sine that stands far above the rest of the spectrum and doesn't go away.
+ The detector looks at the plugin's output for exactly that, and the suppressor drops a narrow notch on
+ every frequency it finds.
+
+ Detection needs a spectrum, but waiting for full FFT frames adds latency and makes the cost come in
+ bursts. Instead, every bin is a sliding DFT with an exponential window: a complex one-pole resonator
+     X[n] = r e^(jw) X[n-1] + x[n]
+ updated every sample. That's a fixed amount of work per sample (one complex multiply-add per bin),
+ and the spectrum is ready to read at any time. Every hop (a few ms) the detector reads the bins:
+     - bins are 1/12 octave apart, each with a bandwidth of 1/12 octave (constant Q), so the high bins
+       react within a few ms and the lowest ones within ~70 ms
+     - a bin is a candidate when it is loud, a local maximum, and way above the average bin level
+     - a candidate that lasts for persistenceSeconds is feedback: its frequency is refined between the
+       neighbouring bins, and a notch from the pool is placed there (or the one already there is deepened)
+ Notches that aren't triggered again for holdSeconds ramp back to 0 dB and go back into the pool.
+
+ Everything runs on the audio thread: the bin count and the pool size are fixed, so the cost per sample
+ is too. Only prepare() allocates.
+
+ The notches are the same second-order sections as the rest of the plugin (transposed direct form II),
+ shared by all channels, each channel with its own state. SimpleeqAudioProcessor runs them right after
+ the Peak stage.
+ */
+class FeedbackSuppressor
+{
+    public:
+    static constexpr int maxChannels = 2;
+    static constexpr int numNotches = 8;
+
+    // detector settings
+    static constexpr double lowestFrequency = 80.0, highestFrequency = 16000.0;
+    static constexpr int binsPerOctave = 12;
+    static constexpr double hopSeconds = 0.003;
+    static constexpr float thresholdDecibels = -40.f;         // absolute level a howl has to reach
+    static constexpr float peakToAverageDecibels = 18.f;      // how far above the average bin it has to be
+    static constexpr double persistenceSeconds = 0.15;
+
+    // notch settings
+    static constexpr double notchQ = 30.0;
+    static constexpr float firstDepthDecibels = 12.f, depthStepDecibels = 6.f, maxDepthDecibels = 30.f;
+    static constexpr double holdSeconds = 10.0;
+    static constexpr double releaseDecibelsPerSecond = 20.0;
+
+    // Sets up the detector bins for the sample rate, and releases every notch. Allocates.
+    void prepare(double sampleRate);
+
+    // Releases every notch and clears the detector.
+    void reset() noexcept;
+
+    // Runs the active notches on one channel, in place.
+    void processNotches(int channel, float* samples, int numSamples) noexcept;
+
+    // Feeds the output to the detector, and updates the notches at every hop.
+    void analyse(const float* const* channels, int numChannels, int numSamples) noexcept;
+
+    int getNumActiveNotches() const noexcept;
+
+    private:
+    struct Notch
+    {
+        float coefficients[5] { 1.f, 0.f, 0.f, 0.f, 0.f }; // b0, b1, b2, a1, a2
+        float state[maxChannels][2] {};
+
+        double frequency = 0;
+        float depthDecibels = 0;   // the notch's current cut, positive
+        int holdHops = 0;          // hops left before it starts releasing
+        bool active = false;
+    };
+
+    std::array<Notch, numNotches> notches;
+
+    // Detector bins. The resonators are updated a SIMD register's worth of bins at a time, the last
+    // register padded with bins that stay at zero frequency and are never read.
+    using Register = juce::dsp::SIMDRegister<float>;
+    static constexpr size_t binsPerRegister = Register::SIMDNumElements;
+
+    std::vector<Register> binCos, binSin;       // r cos(w), r sin(w)
+    std::vector<Register> binReal, binImag;     // the resonators' states
+    std::vector<float> binNormalisation;        // 2 (1 - r): turns |X| into the amplitude of a sine at the bin
+    std::vector<float> binDecibels;
+    std::vector<int> binPersistence;            // hops in a row the bin has been a candidate
+    std::vector<double> binFrequencies;
+
+    double sampleRate = 44100.0;
+    int hopLength = 128, samplesUntilHop = 128;
+    int persistenceHops = 1, holdHopsAfterTrigger = 1;
+    float releaseDecibelsPerHop = 0.1f;
+
+    void updateBins(const float* const* channels, int numChannels, int startSample, int numSamples) noexcept;
+    void runHop() noexcept;
+    void trigger(double frequency) noexcept;
+    void updateNotchCoefficients(Notch& notch) noexcept;
+};
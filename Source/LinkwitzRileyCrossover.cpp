@@ -0,0 +1,119 @@
+/*
+ ==============================================================================
+
+ Three band Linkwitz-Riley crossover for the low/mid/high output buses.
+
+ ==============================================================================
+ */
+
+#include "LinkwitzRileyCrossover.h"
+
+void LinkwitzRileyCrossover::reset() noexcept
+{
+    for (auto& channels : splits)
+        for (auto& split : channels)
+            split.reset();
+}
+
+void LinkwitzRileyCrossover::setSplit(int split, const SplitSections& lowPass, const SplitSections& highPass, Order order) noexcept
+{
+    jassert(juce::isPositiveAndBelow(split, numSplits));
+
+    auto newNumSections = numSectionsForOrder(order);
+
+    // the sections that come into use still hold whatever they had from the last time
+    if (newNumSections != numSections)
+    {
+        reset();
+        numSections = newNumSections;
+    }
+
+    for (auto& channel : splits[(size_t) split])
+    {
+        channel.shared.coefficients = lowPass[0];
+
+        for (size_t i = 0; i < (size_t) numSections; ++i)
+        {
+            channel.lowPass[i].coefficients = lowPass[i];
+            channel.highPass[i].coefficients = highPass[i];
+            channel.lowPassAgain[i].coefficients = lowPass[i];
+            channel.highPassAgain[i].coefficients = highPass[i];
+
+            // out = input - 2k * bandpass turns the section's poles into a second-order all pass
+            auto allPass = lowPass[i];
+            allPass.m0 = 1.f;
+            allPass.m1 = -2.f * allPass.k;
+            allPass.m2 = 0.f;
+            channel.allPass[i].coefficients = allPass;
+        }
+    }
+}
+
+void LinkwitzRileyCrossover::process(int channel, const float* input, float* low, float* mid, float* high, int numSamples) noexcept
+{
+    jassert(juce::isPositiveAndBelow(channel, maxChannels));
+
+    auto& lowSplit = splits[0][(size_t) channel];
+    auto& highSplit = splits[1][(size_t) channel];
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        float lowBand, rest, midBand, highBand;
+
+        lowSplit.processSample(input[i], lowBand, rest, numSections);
+        highSplit.processSample(rest, midBand, highBand, numSections);
+        lowBand = highSplit.processAllPass(lowBand, numSections);
+
+        if (low != nullptr)  low[i] = lowBand;
+        if (mid != nullptr)  mid[i] = midBand;
+        if (high != nullptr) high[i] = highBand;
+    }
+
+    lowSplit.snapToZero();
+    highSplit.snapToZero();
+}
+
+//==============================================================================
+void LinkwitzRileyCrossover::Split::processSample(float input, float& lowOut, float& highOut, int numSections) noexcept
+{
+    float bandPass;
+    shared.processSample(input, lowOut, bandPass, highOut);
+
+    for (size_t i = 1; i < (size_t) numSections; ++i)
+    {
+        lowOut = lowPass[i].processSample(lowOut);
+        highOut = highPass[i].processSample(highOut);
+    }
+
+    for (size_t i = 0; i < (size_t) numSections; ++i)
+    {
+        lowOut = lowPassAgain[i].processSample(lowOut);
+        highOut = highPassAgain[i].processSample(highOut);
+    }
+}
+
+float LinkwitzRileyCrossover::Split::processAllPass(float input, int numSections) noexcept
+{
+    for (size_t i = 0; i < (size_t) numSections; ++i)
+        input = allPass[i].processSample(input);
+
+    return input;
+}
+
+void LinkwitzRileyCrossover::Split::reset() noexcept
+{
+    shared.reset();
+
+    for (auto* filters : { &lowPass, &highPass, &lowPassAgain, &highPassAgain, &allPass })
+        for (auto& filter : *filters)
+            filter.reset();
+}
+
+void LinkwitzRileyCrossover::Split::snapToZero() noexcept
+{
+    shared.snapToZero();
+
+    for (auto* filters : { &lowPass, &highPass, &lowPassAgain, &highPassAgain, &allPass })
+        for (auto& filter : *filters)
+            filter.snapToZero();
+}
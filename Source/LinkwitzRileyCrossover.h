@@ -0,0 +1,82 @@
+/*
+ ==============================================================================
+
+ Three band Linkwitz-Riley crossover for the low/mid/high output buses.
+
+ ==============================================================================
+ */
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "SvfFilter.h"
+
+/*
+ A Linkwitz-Riley filter is a Butterworth filter applied twice: LR4 is the 12 dB/Oct Butterworth squared,
+ LR8 the 24 dB/Oct one. The squared low and high pass at the same frequency add up to an all pass,
+     LP^2 + HP^2 = B(-s) / B(s)     (B = the Butterworth denominator, for even orders)
+ so the bands of a crossover sum back to the input with a flat magnitude.
+
+ The three bands come from two splits arranged as a tree, so each split only runs once:
+     input -> split at f1 -> low
+                          -> rest -> split at f2 -> mid
+                                                 -> high
+ and the low band goes through the all pass of the f2 split, to match the phase the mid and high bands
+ picked up there. Then low + mid + high = AP(f1) AP(f2) input.
+
+ Work shared inside a split:
+     - the coefficients are designed once and used by both branches, every channel and the all pass
+     - every section is a state variable filter (see SvfFilter.h), which gives the low and high pass of
+       its input from one update. The first section sees the same input on both branches, so it runs once.
+
+ The sections are the ones makeSvfLowCutFilter()/makeSvfHighCutFilter() build, i.e. the same Butterworth
+ designs as makeLowCutFilter()/makeHighCutFilter(), in state variable form.
+ */
+class LinkwitzRileyCrossover
+{
+    public:
+    static constexpr int maxChannels = 2;
+    static constexpr int numSplits = 2;
+    static constexpr int maxSectionsPerSplit = 2; // LR8: two sections per Butterworth pass
+
+    enum Order
+    {
+        Order_LR4,
+        Order_LR8
+    };
+
+    using SplitSections = std::array<SvfCoefficients, 4>; // as returned by makeSvfLowCutFilter()/makeSvfHighCutFilter()
+
+    void reset() noexcept;
+
+    // split 0 is the low/mid split, split 1 the mid/high one. Only the first numSectionsForOrder() sections are used,
+    // and the low and high pass sections must share their cutoff.
+    void setSplit(int split, const SplitSections& lowPass, const SplitSections& highPass, Order order) noexcept;
+
+    static int numSectionsForOrder(Order order) noexcept { return order == Order_LR8 ? 2 : 1; }
+
+    // Splits one channel of input into the three bands. Any band can be nullptr if nothing listens to it.
+    // The outputs mustn't alias the input.
+    void process(int channel, const float* input, float* low, float* mid, float* high, int numSamples) noexcept;
+
+    private:
+    struct Split
+    {
+        // the first section of the first pass, shared by both branches
+        SvfFilter shared;
+
+        // the remaining sections of the first pass, then the second pass (index 0 of the first pass is unused)
+        std::array<SvfFilter, maxSectionsPerSplit> lowPass, highPass, lowPassAgain, highPassAgain;
+
+        // only used on split 1, for the low band
+        std::array<SvfFilter, maxSectionsPerSplit> allPass;
+
+        void processSample(float input, float& lowOut, float& highOut, int numSections) noexcept;
+        float processAllPass(float input, int numSections) noexcept;
+        void reset() noexcept;
+        void snapToZero() noexcept;
+    };
+
+    std::array<std::array<Split, maxChannels>, numSplits> splits;
+    int numSections { 1 };
+};
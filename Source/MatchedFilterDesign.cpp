@@ -0,0 +1,147 @@
+/*
+ ==============================================================================
+
+ Matched second-order filter designs.
+
+ ==============================================================================
+ */
+
+#include "MatchedFilterDesign.h"
+
+namespace
+{
+    // An analog second-order section, with s normalised to the centre frequency:
+    // H(s) = (n0 + n1 s + n2 s^2) / (1 + s/Q + s^2)
+    struct AnalogSection
+    {
+        double n0, n1, n2, Q;
+
+        double getMagnitudeSquared(double w) const
+        {
+            auto numRe = n0 - n2 * w * w;
+            auto numIm = n1 * w;
+            auto denRe = 1.0 - w * w;
+            auto denIm = w / Q;
+
+            return (numRe * numRe + numIm * numIm) / (denRe * denRe + denIm * denIm);
+        }
+    };
+
+    std::array<double, 6> makeMatchedSection(double sampleRate, double frequency, const AnalogSection& analog)
+    {
+        jassert(sampleRate > 0);
+        jassert(frequency > 0 && frequency < sampleRate * 0.5);
+
+        using namespace juce;
+
+        auto w0 = MathConstants<double>::twoPi * frequency / sampleRate;
+        auto zeta = 1.0 / (2.0 * analog.Q);
+
+        // Poles: impulse invariance, so the decay and ring frequency are exactly the analog ones.
+        auto a1 = zeta <= 1.0 ? -2.0 * std::exp(-zeta * w0) * std::cos(std::sqrt(1.0 - zeta * zeta) * w0)
+                              : -2.0 * std::exp(-zeta * w0) * std::cosh(std::sqrt(zeta * zeta - 1.0) * w0);
+        auto a2 = std::exp(-2.0 * zeta * w0);
+
+        // |A(e^jw)|^2 = A0 phi0 + A1 phi1 + A2 phi2, where phi1 = sin^2(w/2), phi0 = 1 - phi1, phi2 = 4 phi0 phi1.
+        // The numerator is written the same way with B0, B1, B2, so matching magnitudes is just linear algebra.
+        auto A0 = (1.0 + a1 + a2) * (1.0 + a1 + a2);
+        auto A1 = (1.0 - a1 + a2) * (1.0 - a1 + a2);
+        auto A2 = -4.0 * a2;
+
+        auto phi1 = std::pow(std::sin(w0 * 0.5), 2.0);
+        auto phi0 = 1.0 - phi1;
+        auto phi2 = 4.0 * phi0 * phi1;
+
+        auto denominatorAtCentre = A0 * phi0 + A1 * phi1 + A2 * phi2;
+
+        if (analog.n0 == 0.0 && analog.n1 == 0.0)
+        {
+            // Highpass: keep the double zero at DC and only match the gain at the centre frequency,
+            // otherwise the stopband would fall at 6 dB/oct instead of 12.
+            auto b0 = std::sqrt(analog.getMagnitudeSquared(1.0) * denominatorAtCentre) / (4.0 * phi1);
+            return { b0, -2.0 * b0, b0, 1.0, a1, a2 };
+        }
+
+        // Match at DC, Nyquist and the centre frequency.
+        auto B0 = A0 * analog.getMagnitudeSquared(0.0);
+        auto B1 = A1 * analog.getMagnitudeSquared(MathConstants<double>::pi / w0);
+        auto B2 = (analog.getMagnitudeSquared(1.0) * denominatorAtCentre - B0 * phi0 - B1 * phi1) / phi2;
+
+        // Back from the squared magnitude to actual coefficients (minimum phase solution).
+        auto sqrtB0 = std::sqrt(B0);
+        auto sqrtB1 = std::sqrt(B1);
+        auto W = 0.5 * (sqrtB0 + sqrtB1);
+
+        auto b0 = 0.5 * (W + std::sqrt(jmax(0.0, W * W + B2)));
+        auto b1 = 0.5 * (sqrtB0 - sqrtB1);
+        auto b2 = b0 != 0.0 ? -B2 / (4.0 * b0) : 0.0;
+
+        return { b0, b1, b2, 1.0, a1, a2 };
+    }
+
+    juce::dsp::IIR::Coefficients<float>* toFloatCoefficients(const std::array<double, 6>& c)
+    {
+        return new juce::dsp::IIR::Coefficients<float>(static_cast<float>(c[0]), static_cast<float>(c[1]), static_cast<float>(c[2]),
+                                                       static_cast<float>(c[3]), static_cast<float>(c[4]), static_cast<float>(c[5]));
+    }
+}
+
+std::array<double, 6> MatchedFilterDesign::makeLowPass(double sampleRate, double frequency, double Q)
+{
+    return makeMatchedSection(sampleRate, frequency, { 1.0, 0.0, 0.0, Q });
+}
+
+std::array<double, 6> MatchedFilterDesign::makeHighPass(double sampleRate, double frequency, double Q)
+{
+    return makeMatchedSection(sampleRate, frequency, { 0.0, 0.0, 1.0, Q });
+}
+
+std::array<double, 6> MatchedFilterDesign::makePeakFilter(double sampleRate, double frequency, double Q, double gainFactor)
+{
+    // Same analog prototype as the RBJ peak filter that JUCE uses:
+    // H(s) = (s^2 + s A/Q + 1) / (s^2 + s/(A Q) + 1), with A = sqrt(gain).
+    auto A = std::sqrt(gainFactor);
+
+    if (gainFactor >= 1.0)
+        return makeMatchedSection(sampleRate, frequency, { 1.0, A / Q, 1.0, A * Q });
+
+    // A cut is the exact inverse of the boost with the reciprocal gain. Matching the cut directly puts
+    // the narrow notch in the numerator, which the three point fit handles badly near Nyquist, so we
+    // design the boost and swap numerator and denominator instead.
+    auto boost = makeMatchedSection(sampleRate, frequency, { 1.0, 1.0 / (A * Q), 1.0, Q / A });
+    return { boost[3], boost[4], boost[5], boost[0], boost[1], boost[2] };
+}
+
+MatchedFilterDesign::CoefficientsPtr MatchedFilterDesign::makePeakFilterCoefficients(double sampleRate, float frequency, float Q, float gainFactor)
+{
+    return toFloatCoefficients(makePeakFilter(sampleRate, frequency, Q, gainFactor));
+}
+
+MatchedFilterDesign::IIRCoefficientsArray MatchedFilterDesign::designIIRHighpassHighOrderButterworthMethod(float frequency, double sampleRate, int order)
+{
+    jassert(order > 0 && order % 2 == 0);
+
+    IIRCoefficientsArray arrayFilters;
+
+    for (int i = 0; i < order / 2; ++i)
+        arrayFilters.add(toFloatCoefficients(makeHighPass(sampleRate, frequency, getButterworthSectionQ(order, i))));
+
+    return arrayFilters;
+}
+
+MatchedFilterDesign::IIRCoefficientsArray MatchedFilterDesign::designIIRLowpassHighOrderButterworthMethod(float frequency, double sampleRate, int order)
+{
+    jassert(order > 0 && order % 2 == 0);
+
+    IIRCoefficientsArray arrayFilters;
+
+    for (int i = 0; i < order / 2; ++i)
+        arrayFilters.add(toFloatCoefficients(makeLowPass(sampleRate, frequency, getButterworthSectionQ(order, i))));
+
+    return arrayFilters;
+}
+
+double MatchedFilterDesign::getButterworthSectionQ(int order, int sectionIndex)
+{
+    return 1.0 / (2.0 * std::cos((2.0 * sectionIndex + 1.0) * juce::MathConstants<double>::pi / (order * 2.0)));
+}
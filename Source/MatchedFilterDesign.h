@@ -0,0 +1,48 @@
+/*
+ ==============================================================================
+
+ Matched second-order filter designs.
+
+ ==============================================================================
+ */
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/*
+ The coefficient helpers in JUCE (IIR::Coefficients::makePeakFilter, FilterDesign::design...ButterworthMethod)
+ use the bilinear transform. The bilinear transform squeezes the whole analog frequency axis into 0..Nyquist,
+ so responses close to Nyquist get "cramped": a peak at 16 kHz loses its upper skirt, and a 20 kHz low cut
+ is pulled down to zero at Nyquist even though the analog filter is still passing signal there.
+
+ The usual fix is oversampling, but that multiplies the cost of every filter. Instead, these designs
+ (after M. Vicanek, "Matched Second Order Digital Filters") place the poles with the impulse invariant
+ method and then solve for the zeros so that the digital magnitude matches the analog prototype at DC,
+ at the centre frequency and at Nyquist. The result follows the analog shape up to Nyquist at the base
+ sample rate, with the same cost per sample as the bilinear designs.
+
+ The function signatures mirror the JUCE ones they replace, so the rest of the plugin can pick between
+ them by looking at ChainSettings::coefficientDesign.
+ */
+struct MatchedFilterDesign
+{
+    using CoefficientsPtr = juce::dsp::IIR::Coefficients<float>::Ptr;
+    using IIRCoefficientsArray = juce::ReferenceCountedArray<juce::dsp::IIR::Coefficients<float>>;
+
+    // Second-order sections, returned as { b0, b1, b2, a0, a1, a2 } in double precision.
+    // These are the building blocks for everything below.
+    static std::array<double, 6> makeLowPass(double sampleRate, double frequency, double Q);
+    static std::array<double, 6> makeHighPass(double sampleRate, double frequency, double Q);
+    static std::array<double, 6> makePeakFilter(double sampleRate, double frequency, double Q, double gainFactor);
+
+    // Drop-in replacements for IIR::Coefficients<float>::makePeakFilter and
+    // FilterDesign<float>::designIIR...HighOrderButterworthMethod (even orders only, like our cut filters).
+    static CoefficientsPtr makePeakFilterCoefficients(double sampleRate, float frequency, float Q, float gainFactor);
+    static IIRCoefficientsArray designIIRHighpassHighOrderButterworthMethod(float frequency, double sampleRate, int order);
+    static IIRCoefficientsArray designIIRLowpassHighOrderButterworthMethod(float frequency, double sampleRate, int order);
+
+    // Q of the i-th second-order section of an even order Butterworth filter.
+    // This is the same formula FilterDesign uses, so both designs split the slope into identical sections.
+    static double getButterworthSectionQ(int order, int sectionIndex);
+};
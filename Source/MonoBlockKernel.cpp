@@ -0,0 +1,169 @@
+/*
+ ==============================================================================
+
+ Time-parallel processing of a single MonoChain.
+
+ ==============================================================================
+ */
+
+#include "MonoBlockKernel.h"
+
+void MonoBlockKernel::reset()
+{
+    for (auto& stage : stages)
+    {
+        stage.state[0] = 0.f;
+        stage.state[1] = 0.f;
+    }
+}
+
+void MonoBlockKernel::setStage(int index, const juce::dsp::IIR::Coefficients<float>& coefficients, bool active)
+{
+    auto& stage = stages[(size_t) index];
+    stage.active = active;
+
+    if (! active)
+        return;
+
+    // our chains only hold second-order sections
+    jassert(coefficients.coefficients.size() == 5);
+
+    bool changed = false;
+
+    for (int i = 0; i < 5; ++i)
+    {
+        if (stage.coefficients[i] != coefficients.coefficients[i])
+        {
+            stage.coefficients[i] = coefficients.coefficients[i];
+            changed = true;
+        }
+    }
+
+    if (changed)
+        stage.computeBlockMatrices();
+}
+
+void MonoBlockKernel::Stage::computeBlockMatrices()
+{
+    // IIR::Filter runs a transposed direct form II:
+    //     y  = b0 x + s0
+    //     s0 = b1 x - a1 y + s1
+    //     s1 = b2 x - a2 y
+    // We simply run that recursion (in double) on unit states and a unit impulse to read off the matrices.
+    const double b0 = coefficients[0], b1 = coefficients[1], b2 = coefficients[2];
+    const double a1 = coefficients[3], a2 = coefficients[4];
+
+    auto step = [&](double x, double (&s)[2])
+    {
+        auto y = b0 * x + s[0];
+        s[0] = b1 * x - a1 * y + s[1];
+        s[1] = b2 * x - a2 * y;
+        return y;
+    };
+
+    alignas(Register::SIMDRegisterSize) float column[blockLength];
+
+    // response to the initial state, with no input
+    for (int k = 0; k < 2; ++k)
+    {
+        double s[2] = { k == 0 ? 1.0 : 0.0, k == 1 ? 1.0 : 0.0 };
+
+        for (int n = 0; n < blockLength; ++n)
+            column[n] = (float) step(0.0, s);
+
+        stateToOutput[k] = Register::fromRawArray(column);
+        stateTransition[0][k] = (float) s[0];
+        stateTransition[1][k] = (float) s[1];
+    }
+
+    // response to an impulse at the start of the block. An impulse at position j is the same response
+    // shifted by j samples, so one run gives us all of D, and the state it leaves behind after
+    // (blockLength - j) samples gives us column j of B.
+    double impulseResponse[blockLength];
+    double s[2] = { 0.0, 0.0 };
+
+    for (int n = 0; n < blockLength; ++n)
+    {
+        impulseResponse[n] = step(n == 0 ? 1.0 : 0.0, s);
+
+        auto j = blockLength - 1 - n;
+        inputToState[0][j] = (float) s[0];
+        inputToState[1][j] = (float) s[1];
+    }
+
+    for (int j = 0; j < blockLength; ++j)
+    {
+        for (int n = 0; n < blockLength; ++n)
+            column[n] = n >= j ? (float) impulseResponse[n - j] : 0.f;
+
+        inputToOutput[j] = Register::fromRawArray(column);
+    }
+}
+
+void MonoBlockKernel::Stage::processBlocks(float* samples, int numSamples)
+{
+    alignas(Register::SIMDRegisterSize) float output[blockLength];
+    auto s0 = state[0];
+    auto s1 = state[1];
+
+    int n = 0;
+
+    for (; n + blockLength <= numSamples; n += blockLength)
+    {
+        auto* x = samples + n;
+
+        // The input terms don't depend on the state, so they're summed first and can run ahead while the
+        // previous block is still finishing. The state terms come last, which keeps the dependency from one
+        // block to the next down to those few operations instead of a chain through the whole block.
+        auto y = inputToOutput[0] * Register::expand(x[0]);
+        auto next0 = inputToState[0][0] * x[0];
+        auto next1 = inputToState[1][0] * x[0];
+
+        for (int j = 1; j < blockLength; ++j)
+        {
+            y += inputToOutput[j] * Register::expand(x[j]);
+            next0 += inputToState[0][j] * x[j];
+            next1 += inputToState[1][j] * x[j];
+        }
+
+        y += stateToOutput[0] * Register::expand(s0) + stateToOutput[1] * Register::expand(s1);
+        next0 += stateTransition[0][0] * s0 + stateTransition[0][1] * s1;
+        next1 += stateTransition[1][0] * s0 + stateTransition[1][1] * s1;
+
+        y.copyToRawArray(output);
+        std::copy(output, output + blockLength, x);
+
+        s0 = next0;
+        s1 = next1;
+    }
+
+    // whatever doesn't fill a whole block goes through the plain recursion
+    const auto b0 = coefficients[0], b1 = coefficients[1], b2 = coefficients[2];
+    const auto a1 = coefficients[3], a2 = coefficients[4];
+
+    for (; n < numSamples; ++n)
+    {
+        auto x = samples[n];
+        auto y = b0 * x + s0;
+        s0 = b1 * x - a1 * y + s1;
+        s1 = b2 * x - a2 * y;
+        samples[n] = y;
+    }
+
+    // same denormal protection IIR::Filter applies after every block
+    juce::dsp::util::snapToZero(s0);
+    juce::dsp::util::snapToZero(s1);
+
+    state[0] = s0;
+    state[1] = s1;
+}
+
+void MonoBlockKernel::process(float* samples, int numSamples)
+{
+    // Stage after stage over the whole buffer, like the ProcessorChain does.
+    for (auto& stage : stages)
+    {
+        if (stage.active)
+            stage.processBlocks(samples, numSamples);
+    }
+}
@@ -0,0 +1,85 @@
+/*
+ ==============================================================================
+
+ Time-parallel processing of a single MonoChain.
+
+ ==============================================================================
+ */
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/*
+ With stereo audio we get some parallelism for free (two chains), but a mono signal goes through
+ the 9 biquads of a MonoChain one sample at a time: every output depends on the previous one, so the
+ CPU spends most of its time waiting on the recursion.
+
+ This kernel uses the "block state-space" form of a biquad instead. For a block of L samples, the
+ L outputs only depend on the state at the start of the block and on the L inputs:
+
+     y[0..L-1] = C * state + D * x[0..L-1]
+     nextState = T * state + B * x[0..L-1]
+
+ C, D, T and B are small matrices we precompute from the biquad coefficients. The outputs of a block
+ are then a handful of SIMD multiply-adds, and only the 2-value state update is serial, once every L
+ samples instead of every sample. L is the width of a SIMD register (4 floats with SSE/NEON).
+
+ The kernel mirrors one MonoChain: it reads the coefficients and bypass flags from it, but keeps its
+ own filter state, since IIR::Filter doesn't expose its state.
+ */
+class MonoBlockKernel
+{
+    public:
+    using Register = juce::dsp::SIMDRegister<float>;
+    static constexpr int blockLength = (int) Register::SIMDNumElements;
+
+    // LowCut (4) + Peak (1) + HighCut (4)
+    static constexpr int maxStages = 9;
+
+    void reset();
+
+    // Copies the coefficients and bypass flags of a MonoChain. Cheap when nothing changed,
+    // so it's fine to call this every block.
+    template<typename ChainType>
+    void updateFromChain(const ChainType& chain)
+    {
+        // indices follow ChainPositions: LowCut, Peak, HighCut
+        updateFromCutFilter(chain.template get<0>(), ! chain.template isBypassed<0>(), 0);
+        setStage(4, *chain.template get<1>().coefficients, ! chain.template isBypassed<1>());
+        updateFromCutFilter(chain.template get<2>(), ! chain.template isBypassed<2>(), 5);
+    }
+
+    void process(float* samples, int numSamples);
+
+    private:
+    struct Stage
+    {
+        Stage() { computeBlockMatrices(); }
+        
+        Register stateToOutput[2];              // columns of C
+        Register inputToOutput[blockLength];    // columns of D (the impulse response, shifted)
+        float stateTransition[2][2];            // T
+        float inputToState[2][blockLength];     // B
+
+        float coefficients[5] { 1.f, 0.f, 0.f, 0.f, 0.f }; // b0, b1, b2, a1, a2 the matrices were built from
+        float state[2] { 0.f, 0.f };
+        bool active { false };
+
+        void computeBlockMatrices();
+        void processBlocks(float* samples, int numSamples);
+    };
+
+    template<typename CutFilterType>
+    void updateFromCutFilter(const CutFilterType& cutFilter, bool chainPositionActive, int firstStage)
+    {
+        setStage(firstStage,     *cutFilter.template get<0>().coefficients, chainPositionActive && ! cutFilter.template isBypassed<0>());
+        setStage(firstStage + 1, *cutFilter.template get<1>().coefficients, chainPositionActive && ! cutFilter.template isBypassed<1>());
+        setStage(firstStage + 2, *cutFilter.template get<2>().coefficients, chainPositionActive && ! cutFilter.template isBypassed<2>());
+        setStage(firstStage + 3, *cutFilter.template get<3>().coefficients, chainPositionActive && ! cutFilter.template isBypassed<3>());
+    }
+
+    void setStage(int index, const juce::dsp::IIR::Coefficients<float>& coefficients, bool active);
+
+    std::array<Stage, maxStages> stages;
+};
@@ -8,24 +8,58 @@
 
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
+#include "Tracing.h"
 
 ResponseCurveComponent::ResponseCurveComponent(SimpleeqAudioProcessor& p) : audioProcessor(p)
 {
+}
+
+ResponseCurveComponent::~ResponseCurveComponent()
+{
+    stopListening();
+}
+
+void ResponseCurveComponent::visibilityChanged()
+{
+    if (isVisible())
+        startListening();
+    else
+        stopListening();
+}
+
+void ResponseCurveComponent::startListening()
+{
+    if (isListening)
+        return;
+    
     const auto& params = audioProcessor.getParameters();
     
     for (auto& param : params)
     {
         param->addListener(this);
     }
+    
+    isListening = true;
+    
+    // the parameters may have moved while we weren't listening, so rebuild the curve on the first tick
+    parametersChanged.set(true);
+    startTimerHz(60);
 }
 
-ResponseCurveComponent::~ResponseCurveComponent()
+void ResponseCurveComponent::stopListening()
 {
+    if (! isListening)
+        return;
+    
+    stopTimer();
+    
     const auto& params = audioProcessor.getParameters();
     for (auto& param : params)
     {
         param->removeListener(this);
     }
+    
+    isListening = false;
 }
 
 void ResponseCurveComponent::parameterValueChanged(int parameterIndex, float newValue)
@@ -35,7 +69,8 @@ void ResponseCurveComponent::parameterValueChanged(int parameterIndex, float new
 
 void ResponseCurveComponent::timerCallback()
 {
-    DBG("params changed");
+    SIMPLEEQ_TRACE_SCOPE("ResponseCurveComponent::timerCallback");
+    
     if (parametersChanged.compareAndSetBool(false, true))
     {
         // update the monochain
@@ -57,6 +92,8 @@ void ResponseCurveComponent::timerCallback()
 
 void ResponseCurveComponent::paint (juce::Graphics& g)
 {
+    SIMPLEEQ_TRACE_SCOPE("ResponseCurveComponent::paint");
+    
     using namespace juce;
     
     // (Our component is opaque, so we must completely fill the background with a solid colour)
@@ -130,8 +167,7 @@ void ResponseCurveComponent::paint (juce::Graphics& g)
 
 
 //==============================================================================
-SimpleeqAudioProcessorEditor::SimpleeqAudioProcessorEditor (SimpleeqAudioProcessor& p)
-: AudioProcessorEditor (&p), audioProcessor (p),
+SimpleeqAudioProcessorEditor::Controls::Controls(SimpleeqAudioProcessor& audioProcessor) :
 
 peakFreqSlider(*audioProcessor.apvts.getParameter("peakfreq"), "Hz"),
 peakGainSlider(*audioProcessor.apvts.getParameter("peakgain"), "dB"),
@@ -148,14 +184,64 @@ peakQualitySliderAttachment(audioProcessor.apvts, "peakquality", peakQualitySlid
 lowCutFreqSliderAttachment(audioProcessor.apvts, "lowcutfreq", lowCutFreqSlider),
 highCutFreqSliderAttachment(audioProcessor.apvts, "highcutfreq", highCutFreqSlider),
 lowCutSlopeSliderAttachment(audioProcessor.apvts, "lowcutslope", lowCutSlopeSlider),
-highCutSlopeSliderAttachment(audioProcessor.apvts, "highcutslope", highCutSlopeSlider)
+highCutSlopeSliderAttachment(audioProcessor.apvts, "highcutslope", highCutSlopeSlider),
+spectrumMatcher(audioProcessor)
 {
+    matchButton.onClick = [this] { chooseFilesAndMatch(); };
+}
+
+void SimpleeqAudioProcessorEditor::Controls::chooseFilesAndMatch()
+{
+    juce::AudioFormatManager formatManager;
+    formatManager.registerBasicFormats();
+    auto wildcard = formatManager.getWildcardForAllFormats();
+    
+    auto flags = juce::FileBrowserComponent::openMode | juce::FileBrowserComponent::canSelectFiles;
     
-    for (auto& comp : getComps())
+    // Two choosers, since a chooser can't be replaced from inside its own callback. Both are owned by the
+    // Controls, so closing the editor while one is open just cancels it.
+    referenceChooser = std::make_unique<juce::FileChooser>("Choose the reference recording (how it should sound)", juce::File(), wildcard);
+    
+    referenceChooser->launchAsync(flags, [this, flags, wildcard](const juce::FileChooser& chooser)
     {
-        addAndMakeVisible(comp);
-    }
+        auto referenceFile = chooser.getResult();
+        
+        if (referenceFile == juce::File())
+            return;
+        
+        targetChooser = std::make_unique<juce::FileChooser>("Choose the target recording (what the EQ will be applied to)",
+                                                            referenceFile.getParentDirectory(), wildcard);
+        
+        targetChooser->launchAsync(flags, [this, referenceFile](const juce::FileChooser& targetFileChooser)
+        {
+            auto targetFile = targetFileChooser.getResult();
+            
+            if (targetFile != juce::File())
+                match(referenceFile, targetFile);
+        });
+    });
+}
+
+void SimpleeqAudioProcessorEditor::Controls::match(const juce::File& referenceFile, const juce::File& targetFile)
+{
+    matchButton.setEnabled(false);
+    matchButton.setButtonText("Matching...");
     
+    // The matcher sets the parameters itself, so the sliders and the response curve follow on their own.
+    // It only calls back while it (and so these Controls) still exist.
+    spectrumMatcher.start(referenceFile, targetFile, [this](const SpectrumMatcher::Result& result)
+    {
+        matchButton.setEnabled(true);
+        matchButton.setButtonText("Match...");
+        
+        if (! result.succeeded)
+            juce::AlertWindow::showMessageBoxAsync(juce::AlertWindow::WarningIcon, "Spectrum match failed", result.errorMessage);
+    });
+}
+
+SimpleeqAudioProcessorEditor::SimpleeqAudioProcessorEditor (SimpleeqAudioProcessor& p)
+: AudioProcessorEditor (&p), audioProcessor (p)
+{
     // Make sure that before the constructor has finished, you've set the
     // editor's size to whatever you need it to be.
     setSize (600, 400);
@@ -168,6 +254,8 @@ SimpleeqAudioProcessorEditor::~SimpleeqAudioProcessorEditor()
 //==============================================================================
 void SimpleeqAudioProcessorEditor::paint (juce::Graphics& g)
 {
+    SIMPLEEQ_TRACE_SCOPE("SimpleeqAudioProcessorEditor::paint");
+    
     using namespace juce;
     
     // (Our component is opaque, so we must completely fill the background with a solid colour)
@@ -175,8 +263,35 @@ void SimpleeqAudioProcessorEditor::paint (juce::Graphics& g)
     
 }
 
+void SimpleeqAudioProcessorEditor::visibilityChanged()
+{
+    if (isVisible())
+        createControlsIfNeeded();
+}
+
+void SimpleeqAudioProcessorEditor::createControlsIfNeeded()
+{
+    if (controls != nullptr)
+        return;
+    
+    controls = std::make_unique<Controls>(audioProcessor);
+    
+    for (auto& comp : controls->getComps())
+    {
+        addAndMakeVisible(comp);
+    }
+    
+    resized();
+}
+
 void SimpleeqAudioProcessorEditor::resized()
 {
+    // nothing to lay out until the editor has been shown
+    if (controls == nullptr)
+        return;
+    
+    auto& c = *controls;
+    
     // This is generally where you'll want to lay out the positions of any
     // subcomponents in your editor..
     
@@ -185,10 +300,14 @@ void SimpleeqAudioProcessorEditor::resized()
     // total bounding area
     auto bounds = getLocalBounds();
     
+    // a strip along the bottom for the match button
+    auto matchArea = bounds.removeFromBottom(30);
+    c.matchButton.setBounds(matchArea.removeFromRight(120).reduced(4));
+    
     // area allocated for the response curve
     auto responseArea = bounds.removeFromTop(bounds.getHeight() * 0.33);
     
-    responseCurveComponent.setBounds(responseArea);
+    c.responseCurveComponent.setBounds(responseArea);
     
     // lowcut stuff on left, highcut on right
     auto lowCutArea = bounds.removeFromLeft(bounds.getWidth() * 0.33);
@@ -197,20 +316,20 @@ void SimpleeqAudioProcessorEditor::resized()
     auto highCutArea = bounds.removeFromRight(bounds.getWidth() * 0.5);
     
     // setting the bounds of the sliders
-    lowCutFreqSlider.setBounds(lowCutArea.removeFromTop(lowCutArea.getHeight() * 0.5));
-    lowCutSlopeSlider.setBounds(lowCutArea);
+    c.lowCutFreqSlider.setBounds(lowCutArea.removeFromTop(lowCutArea.getHeight() * 0.5));
+    c.lowCutSlopeSlider.setBounds(lowCutArea);
     
-    highCutFreqSlider.setBounds(highCutArea.removeFromTop(highCutArea.getHeight() * 0.5));
-    highCutSlopeSlider.setBounds(highCutArea);
+    c.highCutFreqSlider.setBounds(highCutArea.removeFromTop(highCutArea.getHeight() * 0.5));
+    c.highCutSlopeSlider.setBounds(highCutArea);
     
     
     // adding peak sliders to the top 0.33 and top 0.66 of the screen
-    peakFreqSlider.setBounds(bounds.removeFromTop(bounds.getHeight() * 0.33));
-    peakGainSlider.setBounds(bounds.removeFromTop(bounds.getHeight() * 0.5));
-    peakQualitySlider.setBounds(bounds);
+    c.peakFreqSlider.setBounds(bounds.removeFromTop(bounds.getHeight() * 0.33));
+    c.peakGainSlider.setBounds(bounds.removeFromTop(bounds.getHeight() * 0.5));
+    c.peakQualitySlider.setBounds(bounds);
 }
 
-std::vector<juce::Component*> SimpleeqAudioProcessorEditor::getComps()
+std::vector<juce::Component*> SimpleeqAudioProcessorEditor::Controls::getComps()
 {
     return
     {
@@ -221,6 +340,7 @@ std::vector<juce::Component*> SimpleeqAudioProcessorEditor::getComps()
         &highCutFreqSlider,
         &lowCutSlopeSlider,
         &highCutSlopeSlider,
-        &responseCurveComponent
+        &responseCurveComponent,
+        &matchButton
     };
 }
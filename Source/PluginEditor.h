@@ -10,6 +10,7 @@
 
 #include <JuceHeader.h>
 #include "PluginProcessor.h"
+#include "SpectrumMatcher.h"
 
 
 struct LookAndFeel : juce::LookAndFeel_V4
@@ -37,7 +38,7 @@ struct RotarySliderWithLabels : juce::Slider
     param(&rap),
     suffix(unitSuffix)
     {
-        setLookAndFeel(&lnf);
+        setLookAndFeel(&lnf.get());
     }
     
     ~RotarySliderWithLabels()
@@ -53,7 +54,8 @@ struct RotarySliderWithLabels : juce::Slider
     juce::String getDisplayString() const;
     
     private:
-    LookAndFeel lnf;
+    // one LookAndFeel for every slider of every open editor, instead of one each
+    juce::SharedResourcePointer<LookAndFeel> lnf;
     juce::RangedAudioParameter* param;
     juce::String suffix;
     
@@ -72,9 +74,17 @@ struct ResponseCurveComponent: juce::Component, juce::AudioProcessorParameter::L
     
     void paint(juce::Graphics& g) override;
     
+    // Listens to the parameters (and polls for changes) only while visible, so an editor that is
+    // constructed but never shown doesn't register a listener on every parameter.
+    void visibilityChanged() override;
+    
     private:
     SimpleeqAudioProcessor& audioProcessor;
     juce::Atomic<bool> parametersChanged { false };
+    bool isListening { false };
+    
+    void startListening();
+    void stopListening();
     
     MonoChain monoChain;
 };
@@ -91,35 +101,59 @@ class SimpleeqAudioProcessorEditor  : public juce::AudioProcessorEditor
     void paint (juce::Graphics&) override;
     void resized() override;
     
+    // the controls get created the first time the editor is made visible
+    void visibilityChanged() override;
+    
     private:
     // This reference is provided as a quick way for your editor to
     // access the processor object that created it.
     SimpleeqAudioProcessor& audioProcessor;
     
-    RotarySliderWithLabels peakFreqSlider,
-    peakGainSlider,
-    peakQualitySlider,
-    lowCutFreqSlider,
-    highCutFreqSlider,
-    lowCutSlopeSlider,
-    highCutSlopeSlider;
-    
-    ResponseCurveComponent responseCurveComponent;
-    
-    using APVTS = juce::AudioProcessorValueTreeState;
-    using Attachment = APVTS::SliderAttachment;
-    
-    Attachment peakFreqSliderAttachment,
-    peakGainSliderAttachment,
-    peakQualitySliderAttachment,
-    lowCutFreqSliderAttachment,
-    highCutFreqSliderAttachment,
-    lowCutSlopeSliderAttachment,
-    highCutSlopeSliderAttachment;
-    
-    // When you have a list of objects that you will do the same thing with, you can add them all to a vector
-    // so you can iterate through them all easily.
-    std::vector<juce::Component*> getComps();
+    // Hosts often construct editors they never show (or show much later), and with many instances that adds up,
+    // so everything below lives in here and is only built on demand (see createControlsIfNeeded()).
+    struct Controls
+    {
+        Controls(SimpleeqAudioProcessor&);
+        
+        RotarySliderWithLabels peakFreqSlider,
+        peakGainSlider,
+        peakQualitySlider,
+        lowCutFreqSlider,
+        highCutFreqSlider,
+        lowCutSlopeSlider,
+        highCutSlopeSlider;
+        
+        ResponseCurveComponent responseCurveComponent;
+        
+        using APVTS = juce::AudioProcessorValueTreeState;
+        using Attachment = APVTS::SliderAttachment;
+        
+        Attachment peakFreqSliderAttachment,
+        peakGainSliderAttachment,
+        peakQualitySliderAttachment,
+        lowCutFreqSliderAttachment,
+        highCutFreqSliderAttachment,
+        lowCutSlopeSliderAttachment,
+        highCutSlopeSliderAttachment;
+        
+        // "Match..." asks for a reference and a target recording, then sets the EQ so the target sounds
+        // like the reference (see SpectrumMatcher.h). The fit runs in the background, the button is
+        // disabled until it's done.
+        juce::TextButton matchButton { "Match..." };
+        SpectrumMatcher spectrumMatcher;
+        std::unique_ptr<juce::FileChooser> referenceChooser, targetChooser;
+        
+        void chooseFilesAndMatch();
+        void match(const juce::File& referenceFile, const juce::File& targetFile);
+        
+        // When you have a list of objects that you will do the same thing with, you can add them all to a vector
+        // so you can iterate through them all easily.
+        std::vector<juce::Component*> getComps();
+    };
+    
+    std::unique_ptr<Controls> controls;
+    
+    void createControlsIfNeeded();
     
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SimpleeqAudioProcessorEditor)
 };
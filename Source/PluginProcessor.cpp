@@ -8,6 +8,7 @@
 
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
+#include "Tracing.h"
 
 //==============================================================================
 SimpleeqAudioProcessor::SimpleeqAudioProcessor()
@@ -18,6 +19,10 @@ SimpleeqAudioProcessor::SimpleeqAudioProcessor()
                   .withInput  ("Input",  juce::AudioChannelSet::stereo(), true)
 #endif
                   .withOutput ("Output", juce::AudioChannelSet::stereo(), true)
+                  // crossover bands (see LinkwitzRileyCrossover.h), off unless the host enables them
+                  .withOutput ("Low",    juce::AudioChannelSet::stereo(), false)
+                  .withOutput ("Mid",    juce::AudioChannelSet::stereo(), false)
+                  .withOutput ("High",   juce::AudioChannelSet::stereo(), false)
 #endif
                   )
 #endif
@@ -26,6 +31,11 @@ SimpleeqAudioProcessor::SimpleeqAudioProcessor()
 
 SimpleeqAudioProcessor::~SimpleeqAudioProcessor()
 {
+   #if SIMPLEEQ_ENABLE_TRACING
+    // The trace buffers are shared by every instance, so the trace written here holds everything recorded so far,
+    // and the last instance to go writes the most complete one.
+    Tracing::writeChromeTraceToEnvironmentPath();
+   #endif
 }
 
 //==============================================================================
@@ -106,6 +116,12 @@ void SimpleeqAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlo
     // we have to prepare both the left and right chains.
     leftChain.prepare(spec);
     rightChain.prepare(spec);
+    leftSvfChain.prepare(spec);
+    rightSvfChain.prepare(spec);
+    monoKernel.reset();
+    chainArena.allocate(ChainArena::maxChannels);
+    feedbackSuppressor.prepare(sampleRate);
+    crossover.reset();
     
     updateFilters();
 
@@ -138,6 +154,11 @@ bool SimpleeqAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts)
         return false;
 #endif
     
+    // The crossover buses are either off, or carry the same channels as the main output.
+    for (int bus = 1; bus < layouts.outputBuses.size(); ++bus)
+        if (! layouts.outputBuses[bus].isDisabled() && layouts.outputBuses[bus] != layouts.getMainOutputChannelSet())
+            return false;
+    
     return true;
 #endif
 }
@@ -149,6 +170,8 @@ bool SimpleeqAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts)
 // We need to make sure all the operations in here finish in a fixed amount of time!
 void SimpleeqAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
 {
+    SIMPLEEQ_TRACE_SCOPE("processBlock");
+    
     // Processor chain requires a processing context to be passed into it to run audio through the
     // links in the Chain. To make a processing context, we need to supply it with an audio block instance.
     
@@ -174,6 +197,9 @@ void SimpleeqAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juc
     // Tip from tutorial: always update your audio process parameters before you run audio through them.
     updateFilters();
     
+    // The crossover reads the input, so it has to run before the main output gets filtered in place.
+    processCrossover(buffer);
+    
     
     // Make sure to reset the state if your inner loop is processing
     // the samples and the outer loop is handling the channels.
@@ -182,17 +208,105 @@ void SimpleeqAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juc
     
     juce::dsp::AudioBlock<float> block(buffer); // start by initializing an AudioBlock, wrapping the buffer.
     
-    // retrieve the left and right audio blocks
-    auto leftBlock = block.getSingleChannelBlock(0);
-    auto rightBlock = block.getSingleChannelBlock(1);
+    // the crossover buses come after the main output's channels, leave them out
+    block = block.getSubsetChannelBlock(0, static_cast<size_t>(getMainBusNumOutputChannels()));
+    
+    processFilters(block);
+    
+    // the detector listens to what actually leaves the plugin
+    if (feedbackSuppression)
+    {
+        std::array<const float*, FeedbackSuppressor::maxChannels> channels {};
+        auto numChannels = juce::jmin(static_cast<int>(block.getNumChannels()), FeedbackSuppressor::maxChannels);
+        
+        for (int channel = 0; channel < numChannels; ++channel)
+            channels[(size_t) channel] = block.getChannelPointer(static_cast<size_t>(channel));
+        
+        feedbackSuppressor.analyse(channels.data(), numChannels, static_cast<int>(block.getNumSamples()));
+    }
+}
+
+void SimpleeqAudioProcessor::processFilters(juce::dsp::AudioBlock<float>& block)
+{
+    if (midSideMode && block.getNumChannels() > 1)
+    {
+        // encode, filter and decode in one pass, see processMidSide() in PluginProcessor.h
+        auto* left = block.getChannelPointer(0);
+        auto* right = block.getChannelPointer(1);
+        auto numSamples = static_cast<int>(block.getNumSamples());
+        
+        if (activeTopology == FilterTopology::Topology_StateVariable)
+            processMidSide(leftSvfChain, rightSvfChain, left, right, numSamples);
+        else
+            processMidSide(leftChain, rightChain, left, right, numSamples);
+        
+        // on the decoded left/right, since that's what the speakers feed back
+        applyNotchesAfterChain(block);
+        return;
+    }
+    
+    if (activeTopology == FilterTopology::Topology_StateVariable)
+    {
+        // same layout as below, just with the state variable chains
+        auto leftBlock = block.getSingleChannelBlock(0);
+        juce::dsp::ProcessContextReplacing<float> leftContext(leftBlock);
+        leftSvfChain.process(leftContext);
+        
+        if (block.getNumChannels() > 1)
+        {
+            auto rightBlock = block.getSingleChannelBlock(1);
+            juce::dsp::ProcessContextReplacing<float> rightContext(rightBlock);
+            rightSvfChain.process(rightContext);
+        }
+        
+        applyNotchesAfterChain(block);
+        return;
+    }
+    
+    if (block.getNumChannels() == 1 && ! feedbackSuppression)
+    {
+        // mono: only the left chain's settings matter, and the kernel processes them several samples at a time.
+        monoKernel.updateFromChain(leftChain);
+        monoKernel.process(block.getChannelPointer(0), static_cast<int>(block.getNumSamples()));
+        return;
+    }
+    
+    // stereo (or mono with feedback suppression, which needs its notches between the Peak and HighCut stages):
+    // updateFilters() has already designed the coefficients into the arena, so the samples only touch the arena.
+    auto numSamples = static_cast<int>(block.getNumSamples());
+    auto numChannels = juce::jmin(static_cast<int>(block.getNumChannels()), ChainArena::maxChannels);
+    
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        auto* samples = block.getChannelPointer(static_cast<size_t>(channel));
+        
+        if (feedbackSuppression)
+        {
+            chainArena.process(channel, samples, numSamples, 0, ChainArena::firstHighCutStage);
+            feedbackSuppressor.processNotches(channel, samples, numSamples);
+            chainArena.process(channel, samples, numSamples, ChainArena::firstHighCutStage, ChainArena::maxStages);
+        }
+        else
+        {
+            chainArena.process(channel, samples, numSamples);
+        }
+    }
+}
+
+// The other paths process a whole chain at once, so the notches can only go after it. Between two
+// detector hops every section is linear and time-invariant, so the order doesn't change the output.
+void SimpleeqAudioProcessor::applyNotchesAfterChain(juce::dsp::AudioBlock<float>& block)
+{
+    if (! feedbackSuppression)
+        return;
+    
+    auto numChannels = juce::jmin(static_cast<int>(block.getNumChannels()), FeedbackSuppressor::maxChannels);
     
-    // initialize the left and right audio contexts to pass into the chain (see PluginProcessor.h for notes).
-    juce::dsp::ProcessContextReplacing<float> leftContext(leftBlock);
-    juce::dsp::ProcessContextReplacing<float> rightContext(rightBlock);
-    leftChain.process(leftContext);
-    rightChain.process(rightContext);
+    for (int channel = 0; channel < numChannels; ++channel)
+        feedbackSuppressor.processNotches(channel, block.getChannelPointer(static_cast<size_t>(channel)), static_cast<int>(block.getNumSamples()));
 }
 
+
 //==============================================================================
 bool SimpleeqAudioProcessor::hasEditor() const
 {
@@ -225,13 +339,16 @@ void SimpleeqAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
 
 void SimpleeqAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
 {
+    SIMPLEEQ_TRACE_SCOPE("setStateInformation");
+    
     // You should use this method to restore your parameters from this memory block,
     // whose contents will have been created by the getStateInformation() call.
     auto tree = juce::ValueTree::readFromData(data, sizeInBytes);
     if (tree.isValid())
     {
+        // Only the parameters change here. updateFilters() resets filter state and switches modes, so it
+        // must only run on the audio thread: processBlock() picks the new values up at its next block.
         apvts.replaceState(tree);
-        updateFilters();
     }
 }
 
@@ -252,12 +369,36 @@ ChainSettings getChainSettings(juce::AudioProcessorValueTreeState& apvts)
     settings.peakQuality = apvts.getRawParameterValue("peakquality") -> load();
     settings.lowCutSlope = static_cast<Slope>(apvts.getRawParameterValue("lowcutslope") -> load());
     settings.highCutSlope = static_cast<Slope>(apvts.getRawParameterValue("highcutslope") -> load());
+    settings.coefficientDesign = static_cast<CoefficientDesign>(apvts.getRawParameterValue("coefficientdesign") -> load());
+    settings.filterTopology = static_cast<FilterTopology>(apvts.getRawParameterValue("filtertopology") -> load());
+    
+    return settings;
+}
+
+ChainSettings getSideChainSettings(juce::AudioProcessorValueTreeState& apvts)
+{
+    // the side chain has its own bands, but shares the design and topology choices with the main one
+    auto settings = getChainSettings(apvts);
+    
+    settings.lowCutFreq = apvts.getRawParameterValue("sidelowcutfreq") -> load();
+    settings.highCutFreq = apvts.getRawParameterValue("sidehighcutfreq") -> load();
+    settings.peakFreq = apvts.getRawParameterValue("sidepeakfreq") -> load();
+    settings.peakGainInDecibels = apvts.getRawParameterValue("sidepeakgain") -> load();
+    settings.peakQuality = apvts.getRawParameterValue("sidepeakquality") -> load();
+    settings.lowCutSlope = static_cast<Slope>(apvts.getRawParameterValue("sidelowcutslope") -> load());
+    settings.highCutSlope = static_cast<Slope>(apvts.getRawParameterValue("sidehighcutslope") -> load());
     
     return settings;
 }
 
 Coefficients makePeakFilter(const ChainSettings& chainSettings, double sampleRate)
 {
+    if (chainSettings.coefficientDesign == CoefficientDesign::Design_Matched)
+        return MatchedFilterDesign::makePeakFilterCoefficients(sampleRate,
+                                                               chainSettings.peakFreq,
+                                                               chainSettings.peakQuality,
+                                                               juce::Decibels::decibelsToGain(chainSettings.peakGainInDecibels));
+    
     return juce::dsp::IIR::Coefficients<float>::makePeakFilter(sampleRate,
                                                                chainSettings.peakFreq,
                                                                chainSettings.peakQuality,
@@ -265,17 +406,75 @@ Coefficients makePeakFilter(const ChainSettings& chainSettings, double sampleRat
 }
 
 
-// Updates all of the settings in the peak filter chain.
-void SimpleeqAudioProcessor::updatePeakFilter(const ChainSettings &chainSettings)
+SvfCoefficients makeSvfPeakFilter(const ChainSettings& chainSettings, double sampleRate)
+{
+    auto gainFactor = juce::Decibels::decibelsToGain(chainSettings.peakGainInDecibels);
+    
+    // the matched design is computed in double and converted, so it keeps its precision too
+    if (chainSettings.coefficientDesign == CoefficientDesign::Design_Matched)
+        return SvfCoefficients::fromBiquad(MatchedFilterDesign::makePeakFilter(sampleRate,
+                                                                               chainSettings.peakFreq,
+                                                                               chainSettings.peakQuality,
+                                                                               gainFactor));
+    
+    return SvfCoefficients::makePeakFilter(sampleRate, chainSettings.peakFreq, chainSettings.peakQuality, gainFactor);
+}
+
+// Same sections as FilterDesign's Butterworth designs: one second-order section per 12 dB/Oct.
+static SvfCutCoefficients makeSvfCutFilter(bool isHighPass, float frequency, int slope, int coefficientDesign, double sampleRate)
+{
+    SvfCutCoefficients sections;
+    auto order = 2 * (slope + 1);
+    
+    for (int i = 0; i <= slope; ++i)
+    {
+        auto Q = MatchedFilterDesign::getButterworthSectionQ(order, i);
+        
+        if (coefficientDesign == CoefficientDesign::Design_Matched)
+            sections[(size_t) i] = SvfCoefficients::fromBiquad(isHighPass ? MatchedFilterDesign::makeHighPass(sampleRate, frequency, Q)
+                                                                           : MatchedFilterDesign::makeLowPass(sampleRate, frequency, Q));
+        else
+            sections[(size_t) i] = isHighPass ? SvfCoefficients::makeHighPass(sampleRate, frequency, Q)
+                                              : SvfCoefficients::makeLowPass(sampleRate, frequency, Q);
+    }
+    
+    return sections;
+}
+
+SvfCutCoefficients makeSvfLowCutFilter(const ChainSettings& chainSettings, double sampleRate)
+{
+    return makeSvfCutFilter(true, chainSettings.lowCutFreq, chainSettings.lowCutSlope, chainSettings.coefficientDesign, sampleRate);
+}
+
+SvfCutCoefficients makeSvfHighCutFilter(const ChainSettings& chainSettings, double sampleRate)
+{
+    return makeSvfCutFilter(false, chainSettings.highCutFreq, chainSettings.highCutSlope, chainSettings.coefficientDesign, sampleRate);
+}
+
+
+ChainCoefficients makeChainCoefficients(const ChainSettings& chainSettings, double sampleRate)
 {
     // IIR::Coefficients are reference-counted objects that own a juce::Array<float>.
     // These helper functions return instances allocated on the heap.
     // You need to dereference them to copy the underlying coefficients array.
     // Tip from tutorial: allocating on the heap in an audio callback is bad, but we will ignore that poor design decision here.
-    auto peakCoefficients = makePeakFilter(chainSettings, getSampleRate());
-    
-    updateCoefficients(leftChain.get<ChainPositions::Peak>().coefficients, peakCoefficients);
-    updateCoefficients(rightChain.get<ChainPositions::Peak>().coefficients, peakCoefficients);
+    return { makePeakFilter(chainSettings, sampleRate),
+             makeLowCutFilter(chainSettings, sampleRate),
+             makeHighCutFilter(chainSettings, sampleRate) };
+}
+
+void updateChain(MonoChain& chain, const ChainCoefficients& coefficients, const ChainSettings& chainSettings)
+{
+    updateCutFilter(chain.get<ChainPositions::LowCut>(), coefficients.lowCut, (Slope)chainSettings.lowCutSlope);
+    updateCoefficients(chain.get<ChainPositions::Peak>().coefficients, coefficients.peak);
+    updateCutFilter(chain.get<ChainPositions::HighCut>(), coefficients.highCut, (Slope)chainSettings.highCutSlope);
+}
+
+void updateChain(ChainArena& arena, int channel, const ChainCoefficients& coefficients, const ChainSettings& chainSettings)
+{
+    updateCutFilter(arena, channel, ChainArena::firstLowCutStage, coefficients.lowCut, (Slope)chainSettings.lowCutSlope);
+    updateCoefficients(arena.getStage(channel, ChainArena::peakStage), coefficients.peak);
+    updateCutFilter(arena, channel, ChainArena::firstHighCutStage, coefficients.highCut, (Slope)chainSettings.highCutSlope);
 }
 
 
@@ -285,90 +484,297 @@ void updateCoefficients(Coefficients &old, const Coefficients &replacements)
     *old = *replacements;
 }
 
+void updateCoefficients(SvfCoefficients &old, const SvfCoefficients &replacements)
+{
+    old = replacements;
+}
 
-void SimpleeqAudioProcessor::updateLowCutFilters(const ChainSettings &chainSettings)
+void updateCoefficients(ChainArena::Stage &stage, const Coefficients &replacements)
 {
-    auto lowCutCoefficients = makeLowCutFilter(chainSettings, getSampleRate());
-    auto& leftLowCut = leftChain.get<ChainPositions::LowCut>();
-    auto& rightLowCut = rightChain.get<ChainPositions::LowCut>();
+    // our chains only hold second-order sections
+    jassert(replacements->coefficients.size() == 5);
+    
+    for (int i = 0; i < 5; ++i)
+        stage.coefficients[i] = replacements->coefficients[i];
     
-    updateCutFilter(leftLowCut, lowCutCoefficients, (Slope)chainSettings.lowCutSlope);
-    updateCutFilter(rightLowCut, lowCutCoefficients, (Slope)chainSettings.lowCutSlope);
+    stage.active = 1;
 }
 
-void SimpleeqAudioProcessor::updateHighCutFilters(const ChainSettings &chainSettings)
+
+void SimpleeqAudioProcessor::updateSvfChains(const ChainSettings &chainSettings, const ChainSettings &rightChainSettings)
 {
-    auto highCutCoefficients = makeHighCutFilter(chainSettings, getSampleRate());
+    updateCutFilter(leftSvfChain.get<ChainPositions::LowCut>(), makeSvfLowCutFilter(chainSettings, getSampleRate()), (Slope)chainSettings.lowCutSlope);
+    updateCutFilter(rightSvfChain.get<ChainPositions::LowCut>(), makeSvfLowCutFilter(rightChainSettings, getSampleRate()), (Slope)rightChainSettings.lowCutSlope);
     
-    auto& leftHighCut = leftChain.get<ChainPositions::HighCut>();
-    auto& rightHighCut = rightChain.get<ChainPositions::HighCut>();
+    updateCoefficients(leftSvfChain.get<ChainPositions::Peak>().coefficients, makeSvfPeakFilter(chainSettings, getSampleRate()));
+    updateCoefficients(rightSvfChain.get<ChainPositions::Peak>().coefficients, makeSvfPeakFilter(rightChainSettings, getSampleRate()));
     
-    updateCutFilter(leftHighCut, highCutCoefficients, (Slope)chainSettings.highCutSlope);
-    updateCutFilter(rightHighCut, highCutCoefficients, (Slope)chainSettings.highCutSlope);
+    updateCutFilter(leftSvfChain.get<ChainPositions::HighCut>(), makeSvfHighCutFilter(chainSettings, getSampleRate()), (Slope)chainSettings.highCutSlope);
+    updateCutFilter(rightSvfChain.get<ChainPositions::HighCut>(), makeSvfHighCutFilter(rightChainSettings, getSampleRate()), (Slope)rightChainSettings.highCutSlope);
 }
 
 void SimpleeqAudioProcessor::updateFilters()
 {
+    SIMPLEEQ_TRACE_SCOPE("updateFilters");
+    
     auto chainSettings = getChainSettings(apvts);
+    auto newMidSideMode = apvts.getRawParameterValue("stereomode") -> load() == StereoMode::Stereo_MidSide;
+    auto newFeedbackSuppression = apvts.getRawParameterValue("feedbacksuppression") -> load() > 0.5f;
+    
+    // start with an empty notch pool every time it's switched on. Mono switches between the kernel and the arena.
+    if (newFeedbackSuppression != feedbackSuppression)
+    {
+        feedbackSuppressor.reset();
+        chainArena.reset();
+        monoKernel.reset();
+        
+        feedbackSuppression = newFeedbackSuppression;
+    }
+    
+    // In mid/side mode the left chains filter the mid signal with the main settings, and the right chains
+    // filter the side signal with the side settings. Otherwise both get the main settings.
+    auto rightChainSettings = newMidSideMode ? getSideChainSettings(apvts) : chainSettings;
+    
+    // The chains' state holds left/right signals in one mode and mid/side in the other, so start over when switching.
+    if (newMidSideMode != midSideMode)
+    {
+        leftChain.reset();
+        rightChain.reset();
+        leftSvfChain.reset();
+        rightSvfChain.reset();
+        monoKernel.reset();
+        chainArena.reset();
+        
+        midSideMode = newMidSideMode;
+    }
+    
+    // Only the chains of the selected topology are kept up to date. When switching, the other set still
+    // holds state from whenever it last ran, so clear it before it takes over.
+    if (chainSettings.filterTopology != activeTopology)
+    {
+        if (chainSettings.filterTopology == FilterTopology::Topology_StateVariable)
+        {
+            leftSvfChain.reset();
+            rightSvfChain.reset();
+        }
+        else
+        {
+            leftChain.reset();
+            rightChain.reset();
+            monoKernel.reset();
+            chainArena.reset();
+        }
+        
+        activeTopology = chainSettings.filterTopology;
+    }
     
     // after you have your chain settings, you can start producing coefficients using the static helper functions
     // that are part of the IIR coefficients class.
-    updateLowCutFilters(chainSettings);
-    updatePeakFilter(chainSettings);
-    updateHighCutFilters(chainSettings);
+    if (chainSettings.filterTopology == FilterTopology::Topology_StateVariable)
+    {
+        updateSvfChains(chainSettings, rightChainSettings);
+    }
+    else
+    {
+        // designed once, and shared by both chains unless they have different settings
+        auto coefficients = makeChainCoefficients(chainSettings, getSampleRate());
+        auto rightCoefficients = midSideMode ? makeChainCoefficients(rightChainSettings, getSampleRate()) : coefficients;
+        
+        updateChain(leftChain, coefficients, chainSettings);
+        updateChain(rightChain, rightCoefficients, rightChainSettings);
+        
+        updateChain(chainArena, 0, coefficients, chainSettings);
+        updateChain(chainArena, 1, rightCoefficients, rightChainSettings);
+    }
+    
+    // nothing to design while the host has all the band buses switched off
+    if (hasCrossoverOutput())
+        updateCrossover(chainSettings);
 }
 
+bool SimpleeqAudioProcessor::hasCrossoverOutput() const
+{
+    // disabled buses have no channels. The layout only changes before prepareToPlay(), which designs the
+    // crossover again through updateFilters().
+    for (int bus = 1; bus < getBusCount(false); ++bus)
+        if (getChannelCountOfBus(false, bus) > 0)
+            return true;
+    
+    return false;
+}
 
+void SimpleeqAudioProcessor::updateCrossover(const ChainSettings& chainSettings)
+{
+    // The splits sit at the low and high cut frequencies.
+    auto order = static_cast<LinkwitzRileyCrossover::Order>(apvts.getRawParameterValue("crossoverslope") -> load());
+    designCrossover(crossover, chainSettings.lowCutFreq, chainSettings.highCutFreq, order, getSampleRate());
+}
 
-juce::AudioProcessorValueTreeState::ParameterLayout SimpleeqAudioProcessor::createParameterLayout()
+void designCrossover(LinkwitzRileyCrossover& crossover, float firstFrequency, float secondFrequency, LinkwitzRileyCrossover::Order order, double sampleRate)
 {
-    juce::AudioProcessorValueTreeState::ParameterLayout layout;
+    // Always designed with the bilinear transform: all sections of a Butterworth filter need the same prewarped
+    // cutoff for the bands to sum flat, and the matched design moves them.
+    auto slope = order == LinkwitzRileyCrossover::Order_LR8 ? Slope::Slope_24 : Slope::Slope_12;
     
-    layout.add(std::make_unique<juce::AudioParameterFloat>(juce::ParameterID {"lowcutfreq", 1},
-                                                           "LowCut Freq",
-                                                           juce::NormalisableRange<float>(20.f, 20000.f, 1.f, 0.25f),
-                                                           20.f));
+    std::array<float, LinkwitzRileyCrossover::numSplits> frequencies { juce::jmin(firstFrequency, secondFrequency),
+                                                                       juce::jmax(firstFrequency, secondFrequency) };
     
-    layout.add(std::make_unique<juce::AudioParameterFloat>(juce::ParameterID {"highcutfreq", 2},
-                                                           "HighCut Freq",
-                                                           juce::NormalisableRange<float>(20.f, 20000.f, 1.f, 0.25f),
-                                                           200000.f));
+    for (int split = 0; split < LinkwitzRileyCrossover::numSplits; ++split)
+    {
+        ChainSettings splitSettings;
+        splitSettings.lowCutFreq = splitSettings.highCutFreq = frequencies[(size_t) split];
+        splitSettings.lowCutSlope = splitSettings.highCutSlope = slope;
+        splitSettings.coefficientDesign = CoefficientDesign::Design_Bilinear;
+        
+        crossover.setSplit(split,
+                           makeSvfHighCutFilter(splitSettings, sampleRate),
+                           makeSvfLowCutFilter(splitSettings, sampleRate),
+                           order);
+    }
+}
+
+void SimpleeqAudioProcessor::processCrossover(juce::AudioBuffer<float>& buffer)
+{
+    if (! hasCrossoverOutput())
+        return;
+    
+    auto input = getBusBuffer(buffer, true, 0);
+    auto low = getBusBuffer(buffer, false, 1);
+    auto mid = getBusBuffer(buffer, false, 2);
+    auto high = getBusBuffer(buffer, false, 3);
+    
+    auto numChannels = juce::jmin(input.getNumChannels(), LinkwitzRileyCrossover::maxChannels);
+    
+    auto getBandPointer = [](juce::AudioBuffer<float>& band, int channel) -> float*
+    {
+        return channel < band.getNumChannels() ? band.getWritePointer(channel) : nullptr;
+    };
+    
+    for (int channel = 0; channel < numChannels; ++channel)
+        crossover.process(channel,
+                          input.getReadPointer(channel),
+                          getBandPointer(low, channel),
+                          getBandPointer(mid, channel),
+                          getBandPointer(high, channel),
+                          buffer.getNumSamples());
+}
+
+
+
+namespace
+{
+    // Everything describing the parameters is the same for every instance, so it's built once here and shared,
+    // instead of on every createParameterLayout() call (which runs once per instance when a session loads).
+    struct FloatParameterSpec
+    {
+        const char* id;
+        int versionHint;
+        const char* name;
+        juce::NormalisableRange<float> range;
+        float defaultValue;
+    };
     
-    layout.add(std::make_unique<juce::AudioParameterFloat>(juce::ParameterID {"peakfreq", 3},
-                                                           "Peak Freq",
-                                                           juce::NormalisableRange<float>(20.f, 20000.f, 1.f, 0.25f),
-                                                           750.f));
+    const juce::NormalisableRange<float> frequencyRange(20.f, 20000.f, 1.f, 0.25f);
     
     // here we're using db instead of frequency (hz), so the values change accordingly
     // a typical range to use is +- 24 db, and the step change is 0.05 of a decible.
-    layout.add(std::make_unique<juce::AudioParameterFloat>(juce::ParameterID {"peakgain", 4},
-                                                           "Peak Gain",
-                                                           juce::NormalisableRange<float>(-24.f, 24.f, 0.5f, 0.25f),
-                                                           0.0f));
+    const juce::NormalisableRange<float> gainRange(-24.f, 24.f, 0.5f, 0.25f);
     
     // how "tight" or "wide" the band is, or Q value
-    layout.add(std::make_unique<juce::AudioParameterFloat>(juce::ParameterID {"peakquality", 5},
-                                                           "Peak Quality",
-                                                           juce::NormalisableRange<float>(0.1f, 10.f, 0.05f, 0.25f),
-                                                           1.f));
-    
+    const juce::NormalisableRange<float> qualityRange(0.1f, 10.f, 0.05f, 0.25f);
+    
+    const std::array<FloatParameterSpec, 5> mainFloatParameters
+    {{
+        { "lowcutfreq",  1, "LowCut Freq",  frequencyRange, 20.f },
+        { "highcutfreq", 2, "HighCut Freq", frequencyRange, 200000.f },
+        { "peakfreq",    3, "Peak Freq",    frequencyRange, 750.f },
+        { "peakgain",    4, "Peak Gain",    gainRange,      0.0f },
+        { "peakquality", 5, "Peak Quality", qualityRange,   1.f }
+    }};
+    
+    // Mid/side mode: the parameters above EQ the mid (L+R) signal, and this second set EQs the side (L-R) signal,
+    // e.g. to low cut only the side. Same ranges and defaults as the main set.
+    const std::array<FloatParameterSpec, 5> sideFloatParameters
+    {{
+        { "sidelowcutfreq",  6,  "Side LowCut Freq",  frequencyRange, 20.f },
+        { "sidehighcutfreq", 7,  "Side HighCut Freq", frequencyRange, 20000.f },
+        { "sidepeakfreq",    8,  "Side Peak Freq",    frequencyRange, 750.f },
+        { "sidepeakgain",    9,  "Side Peak Gain",    gainRange,      0.0f },
+        { "sidepeakquality", 10, "Side Peak Quality", qualityRange,   1.f }
+    }};
     
     // for lowcut and highcut filters, we want to adjust steepness, we'll get 4 different options.
     // cut option responses are expressed as decibles per octave, and the math typically rounds out
     // to multiples of 6 or 12 db/octave
     // we will use: 12, 24, 36, 48
     // because our options are more limited, we use the AudioParameterChoice instead.
-    juce::StringArray stringArray;
-    for (int i = 0; i < 4; i++)
+    const juce::StringArray& getSlopeChoices()
+    {
+        static const juce::StringArray stringArray = []
+        {
+            juce::StringArray choices;
+            
+            for (int i = 0; i < 4; i++)
+            {
+                juce::String str;
+                str << (12 + i*12);
+                str << " db/Oct";
+                choices.add(str);
+            }
+            
+            return choices;
+        }();
+        
+        return stringArray;
+    }
+    
+    void addFloatParameters(juce::AudioProcessorValueTreeState::ParameterLayout& layout, const std::array<FloatParameterSpec, 5>& specs)
     {
-        juce::String str;
-        str << (12 + i*12);
-        str << " db/Oct";
-        stringArray.add(str);
+        for (const auto& spec : specs)
+            layout.add(std::make_unique<juce::AudioParameterFloat>(juce::ParameterID {spec.id, spec.versionHint},
+                                                                   spec.name,
+                                                                   spec.range,
+                                                                   spec.defaultValue));
     }
+}
+
+juce::AudioProcessorValueTreeState::ParameterLayout SimpleeqAudioProcessor::createParameterLayout()
+{
+    // Slope of the Linkwitz-Riley crossover feeding the Low/Mid/High output buses (split at the low and high cut frequencies).
+    static const juce::StringArray crossoverChoices { "24 db/Oct (LR4)", "48 db/Oct (LR8)" };
+    static const juce::StringArray stereoModeChoices { "Stereo", "Mid/Side" };
+    
+    // Bilinear designs are the classic ones, but they get squashed near Nyquist (a 16 kHz peak loses
+    // its upper half at 44.1 kHz). Matched designs keep the analog shape without having to oversample.
+    static const juce::StringArray designChoices { "Bilinear", "Matched" };
+    
+    // Direct form is the classic IIR::Filter. State variable filters cost a bit more, but stay clean in float
+    // when a cutoff is tiny compared to the sample rate (like a 20 Hz low cut at 192 kHz).
+    static const juce::StringArray topologyChoices { "Direct Form", "State Variable" };
+    
+    // For live sound: finds howling frequencies on the output and notches them out (see FeedbackSuppressor.h).
+    static const juce::StringArray feedbackSuppressionChoices { "Off", "On" };
+    
+    const auto& slopeChoices = getSlopeChoices();
+    
+    juce::AudioProcessorValueTreeState::ParameterLayout layout;
+    
+    addFloatParameters(layout, mainFloatParameters);
+    
+    layout.add(std::make_unique<juce::AudioParameterChoice>("lowcutslope", "LowCut Slope", slopeChoices, 0));
+    layout.add(std::make_unique<juce::AudioParameterChoice>("highcutslope", "HighCut Slope", slopeChoices, 0));
+    
+    layout.add(std::make_unique<juce::AudioParameterChoice>("crossoverslope", "Crossover Slope", crossoverChoices, 0));
+    
+    layout.add(std::make_unique<juce::AudioParameterChoice>("stereomode", "Stereo Mode", stereoModeChoices, 0));
+    addFloatParameters(layout, sideFloatParameters);
+    layout.add(std::make_unique<juce::AudioParameterChoice>("sidelowcutslope", "Side LowCut Slope", slopeChoices, 0));
+    layout.add(std::make_unique<juce::AudioParameterChoice>("sidehighcutslope", "Side HighCut Slope", slopeChoices, 0));
+    
+    layout.add(std::make_unique<juce::AudioParameterChoice>("coefficientdesign", "Coefficient Design", designChoices, 0));
+    layout.add(std::make_unique<juce::AudioParameterChoice>("filtertopology", "Filter Topology", topologyChoices, 0));
     
-    layout.add(std::make_unique<juce::AudioParameterChoice>("lowcutslope", "LowCut Slope", stringArray, 0));
-    layout.add(std::make_unique<juce::AudioParameterChoice>("highcutslope", "HighCut Slope", stringArray, 0));
+    layout.add(std::make_unique<juce::AudioParameterChoice>("feedbacksuppression", "Feedback Suppression", feedbackSuppressionChoices, 0));
     
     // we have our parameters setup now in a ParameterLayout, so we can just pass the layout to the
     // AudioProcessorValueTreeState constructor (code is in the header file);
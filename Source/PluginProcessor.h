@@ -9,6 +9,12 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include "MatchedFilterDesign.h"
+#include "MonoBlockKernel.h"
+#include "SvfFilter.h"
+#include "LinkwitzRileyCrossover.h"
+#include "ChainArena.h"
+#include "FeedbackSuppressor.h"
 
 enum Slope : int
 {
@@ -18,14 +24,42 @@ enum Slope : int
     Slope_48
 };
 
+// How the filter coefficients are produced from the knob settings.
+// Bilinear is the classic RBJ/Butterworth design, Matched keeps the analog shape up to Nyquist
+// (see MatchedFilterDesign.h).
+enum CoefficientDesign : int
+{
+    Design_Bilinear,
+    Design_Matched
+};
+
+// How each filter section is realised. Direct form is IIR::Filter; state variable is the TPT
+// structure from SvfFilter.h, which stays accurate in float at very low cutoff / sample rate ratios.
+enum FilterTopology : int
+{
+    Topology_DirectForm,
+    Topology_StateVariable
+};
+
 struct ChainSettings
 {
     float peakFreq { 0 }, peakGainInDecibels{ 0 }, peakQuality{ 1.f };
     float lowCutFreq { 0 }, highCutFreq { 0 };
     int lowCutSlope { Slope::Slope_12 }, highCutSlope { Slope::Slope_12 };
+    int coefficientDesign { CoefficientDesign::Design_Bilinear };
+    int filterTopology { FilterTopology::Topology_DirectForm };
 };
 
 ChainSettings getChainSettings(juce::AudioProcessorValueTreeState& apvts);
+ChainSettings getSideChainSettings(juce::AudioProcessorValueTreeState& apvts);
+
+// Stereo runs the two chains on left and right. Mid/side runs them on (L+R)/2 and (L-R)/2 instead,
+// with separate settings for each (see getSideChainSettings).
+enum StereoMode : int
+{
+    Stereo_LeftRight,
+    Stereo_MidSide
+};
 
 // JUCE DSP namespace uses a lot of template metaprogramming and nested namespaces, so we're gonna
 // create some type aliases to make things simpler.
@@ -46,6 +80,11 @@ using CutFilter = juce::dsp::ProcessorChain<Filter, Filter, Filter, Filter>;
 // We define a chain to represent 1 mono signal path: LowCut -> Parametric -> HighCut.
 using MonoChain = juce::dsp::ProcessorChain<CutFilter, Filter, CutFilter>;
 
+// The same chain built from state variable sections. Positions and slopes work exactly like the
+// MonoChain, so updateCutFilter() and the ChainPositions work on both.
+using SvfCutFilter = juce::dsp::ProcessorChain<SvfFilter, SvfFilter, SvfFilter, SvfFilter>;
+using SvfMonoChain = juce::dsp::ProcessorChain<SvfCutFilter, SvfFilter, SvfCutFilter>;
+
 
 enum ChainPositions // all of the filters we have in a Mono Chain
 {
@@ -59,6 +98,15 @@ void updateCoefficients(Coefficients& old, const Coefficients& replacements);
 
 Coefficients makePeakFilter(const ChainSettings& chainSettings, double sampleRate);
 
+// State variable versions of the coefficient helpers. These are plain values (no heap allocation), and
+// only the first (slope + 1) entries of the cut filter arrays are used, like the IIR ones.
+void updateCoefficients(SvfCoefficients& old, const SvfCoefficients& replacements);
+
+using SvfCutCoefficients = std::array<SvfCoefficients, 4>;
+SvfCoefficients makeSvfPeakFilter(const ChainSettings& chainSettings, double sampleRate);
+SvfCutCoefficients makeSvfLowCutFilter(const ChainSettings& chainSettings, double sampleRate);
+SvfCutCoefficients makeSvfHighCutFilter(const ChainSettings& chainSettings, double sampleRate);
+
 template<int Index, typename ChainType, typename CoefficientType>
 void update(ChainType& chain, const CoefficientType& coefficients)
 {
@@ -90,6 +138,98 @@ void updateCutFilter(ChainType& chain,
     }
 }
 
+// The stereo direct form path runs out of a ChainArena (see ChainArena.h), so updateFilters() designs into
+// its stages too. These work like the chain versions above: a stage becomes active once it gets coefficients.
+void updateCoefficients(ChainArena::Stage& stage, const Coefficients& replacements);
+
+template<typename CoefficientType>
+void updateCutFilter(ChainArena& arena,
+                     int channel,
+                     int firstStage,
+                     const CoefficientType& coefficients,
+                     const Slope& slope)
+{
+    // bypassing all of the stages of this cut filter
+    for (int i = 0; i < 4; ++i)
+        arena.getStage(channel, firstStage + i).active = 0;
+    
+    switch (slope)
+    {
+        case Slope_48:
+            updateCoefficients(arena.getStage(channel, firstStage + 3), coefficients[3]);
+        case Slope_36:
+            updateCoefficients(arena.getStage(channel, firstStage + 2), coefficients[2]);
+        case Slope_24:
+            updateCoefficients(arena.getStage(channel, firstStage + 1), coefficients[1]);
+        case Slope_12:
+            updateCoefficients(arena.getStage(channel, firstStage), coefficients[0]);
+    }
+}
+
+// Runs one sample through a whole chain, skipping bypassed links like ProcessorChain::process does.
+// Works for both MonoChain and SvfMonoChain.
+template<typename CutFilterType>
+float processCutFilterSample(CutFilterType& cutFilter, float sample)
+{
+    if (! cutFilter.template isBypassed<0>()) sample = cutFilter.template get<0>().processSample(sample);
+    if (! cutFilter.template isBypassed<1>()) sample = cutFilter.template get<1>().processSample(sample);
+    if (! cutFilter.template isBypassed<2>()) sample = cutFilter.template get<2>().processSample(sample);
+    if (! cutFilter.template isBypassed<3>()) sample = cutFilter.template get<3>().processSample(sample);
+    
+    return sample;
+}
+
+template<typename ChainType>
+float processChainSample(ChainType& chain, float sample)
+{
+    if (! chain.template isBypassed<ChainPositions::LowCut>())
+        sample = processCutFilterSample(chain.template get<ChainPositions::LowCut>(), sample);
+    
+    if (! chain.template isBypassed<ChainPositions::Peak>())
+        sample = chain.template get<ChainPositions::Peak>().processSample(sample);
+    
+    if (! chain.template isBypassed<ChainPositions::HighCut>())
+        sample = processCutFilterSample(chain.template get<ChainPositions::HighCut>(), sample);
+    
+    return sample;
+}
+
+// processSample() doesn't flush denormals like process() does, so this is done once per block instead.
+template<typename CutFilterType>
+void snapCutFilterToZero(CutFilterType& cutFilter)
+{
+    cutFilter.template get<0>().snapToZero();
+    cutFilter.template get<1>().snapToZero();
+    cutFilter.template get<2>().snapToZero();
+    cutFilter.template get<3>().snapToZero();
+}
+
+template<typename ChainType>
+void snapChainToZero(ChainType& chain)
+{
+    snapCutFilterToZero(chain.template get<ChainPositions::LowCut>());
+    chain.template get<ChainPositions::Peak>().snapToZero();
+    snapCutFilterToZero(chain.template get<ChainPositions::HighCut>());
+}
+
+// Mid/side EQ in a single pass over the buffer: each sample is encoded, sent through the mid and side chains,
+// and decoded straight back into the left/right channels, so no intermediate mid/side buffers are needed.
+template<typename ChainType>
+void processMidSide(ChainType& midChain, ChainType& sideChain, float* left, float* right, int numSamples)
+{
+    for (int i = 0; i < numSamples; ++i)
+    {
+        auto mid = processChainSample(midChain, 0.5f * (left[i] + right[i]));
+        auto side = processChainSample(sideChain, 0.5f * (left[i] - right[i]));
+        
+        left[i] = mid + side;
+        right[i] = mid - side;
+    }
+    
+    snapChainToZero(midChain);
+    snapChainToZero(sideChain);
+}
+
 inline auto makeLowCutFilter(const ChainSettings& chainSettings, double sampleRate)
 {
     // Refer to the implementation of the designIIRHighpassHighOrderButterworthMethod function for how this works.
@@ -99,6 +239,11 @@ inline auto makeLowCutFilter(const ChainSettings& chainSettings, double sampleRa
     // This slope parameter had 4 choices, as multiples of 12 (slope -> db/oct, 0 -> 12, 1 -> 24, 2 -> 35,  3 -> 48).
     // So, for a slope of 12, we would need an order of 2 for 1 IIR filter object,
     // for a slope of 24 we would need an order of 4 for 2 IIR filter objects, and so on and so forth.
+    if (chainSettings.coefficientDesign == CoefficientDesign::Design_Matched)
+        return MatchedFilterDesign::designIIRHighpassHighOrderButterworthMethod(chainSettings.lowCutFreq,
+                                                                                sampleRate,
+                                                                                2 * (chainSettings.lowCutSlope + 1));
+    
     return juce::dsp::FilterDesign<float>::designIIRHighpassHighOrderButterworthMethod(chainSettings.lowCutFreq,
                                                                                        sampleRate,
                                                                                        2 * (chainSettings.lowCutSlope + 1));
@@ -106,11 +251,39 @@ inline auto makeLowCutFilter(const ChainSettings& chainSettings, double sampleRa
 
 inline auto makeHighCutFilter(const ChainSettings& chainSettings, double sampleRate)
 {
+    if (chainSettings.coefficientDesign == CoefficientDesign::Design_Matched)
+        return MatchedFilterDesign::designIIRLowpassHighOrderButterworthMethod(chainSettings.highCutFreq,
+                                                                               sampleRate,
+                                                                               2 * (chainSettings.highCutSlope + 1));
+    
     return juce::dsp::FilterDesign<float>::designIIRLowpassHighOrderButterworthMethod(chainSettings.highCutFreq,
                                                                                       sampleRate,
                                                                                       2 * (chainSettings.highCutSlope + 1));
 }
 
+// Everything updateFilters() designs for one direct form chain, designed once so that chains (and ChainArena
+// channels) with the same settings can share it.
+struct ChainCoefficients
+{
+    Coefficients peak;
+    MatchedFilterDesign::IIRCoefficientsArray lowCut, highCut;
+};
+
+ChainCoefficients makeChainCoefficients(const ChainSettings& chainSettings, double sampleRate);
+
+// The chain update sequence of updateFilters(): low cut, peak and high cut, with the slopes from the settings.
+// The tests and benchmarks set up their chains through these too, so they always match the plugin.
+void updateChain(MonoChain& chain, const ChainCoefficients& coefficients, const ChainSettings& chainSettings);
+void updateChain(ChainArena& arena, int channel, const ChainCoefficients& coefficients, const ChainSettings& chainSettings);
+
+inline void updateChain(MonoChain& chain, const ChainSettings& chainSettings, double sampleRate)
+{
+    updateChain(chain, makeChainCoefficients(chainSettings, sampleRate), chainSettings);
+}
+
+// Designs both splits of a crossover, at two frequencies in either order.
+void designCrossover(LinkwitzRileyCrossover& crossover, float firstFrequency, float secondFrequency, LinkwitzRileyCrossover::Order order, double sampleRate);
+
 
 //==============================================================================
 /**
@@ -172,9 +345,37 @@ class SimpleeqAudioProcessor  : public juce::AudioProcessor
     private:
     MonoChain leftChain, rightChain; // two chains for Stereo out.
     
-    void updatePeakFilter(const ChainSettings& chainSettings);
-    void updateLowCutFilters(const ChainSettings& chainSettings);
-    void updateHighCutFilters(const ChainSettings& chainSettings);
+    // With a mono bus there's no second chain to run in parallel, so the left chain's filters are run
+    // through this time-parallel kernel instead (see MonoBlockKernel.h).
+    MonoBlockKernel monoKernel;
+    
+    // The stereo direct form path runs out of this instead of the chains themselves (see ChainArena.h).
+    // updateFilters() keeps it up to date alongside the chains, which the mono and mid/side paths still use.
+    ChainArena chainArena;
+    
+    // Used instead of the chains above when the "filtertopology" parameter selects state variable filters.
+    SvfMonoChain leftSvfChain, rightSvfChain;
+    int activeTopology { FilterTopology::Topology_DirectForm };
+    bool midSideMode { false };
+    
+    // Feeds the optional "Low", "Mid" and "High" output buses, split at the low and high cut frequencies.
+    LinkwitzRileyCrossover crossover;
+    bool hasCrossoverOutput() const;
+    void updateCrossover(const ChainSettings& chainSettings);
+    void processCrossover(juce::AudioBuffer<float>& buffer);
+    
+    // Notches after the Peak stage, placed by a howl detector on the output ("feedbacksuppression" parameter).
+    FeedbackSuppressor feedbackSuppressor;
+    bool feedbackSuppression { false };
+    void applyNotchesAfterChain(juce::dsp::AudioBlock<float>& block);
+    
+    // runs the active chains on the main output
+    void processFilters(juce::dsp::AudioBlock<float>& block);
+    
+    // rightChainSettings is only different from chainSettings in mid/side mode
+    void updateSvfChains(const ChainSettings& chainSettings, const ChainSettings& rightChainSettings);
+    
+    // Resets filter state on mode/topology switches: only call it from prepareToPlay() and processBlock().
     void updateFilters();
     
     //==============================================================================
@@ -0,0 +1,58 @@
+/*
+ ==============================================================================
+
+ Fork/join helper for running a batch of independent tasks on a ThreadPool.
+
+ ==============================================================================
+ */
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/*
+ Runs task(0) ... task(numTasks - 1) on the pool, with the calling thread taking tasks too, and waits for
+ all of them.
+
+ Because the caller works through the tasks itself, this is safe to call from a job on the same pool (or
+ on a pool with a single thread): if no other pool thread is free, the caller simply does all the work
+ alone. With no tasks it returns straight away.
+ */
+template<typename Task>
+void runInParallel(juce::ThreadPool& threadPool, int numTasks, Task&& task)
+{
+    if (numTasks <= 0)
+        return;
+
+    // Helpers that only start after everything is done must still find the counters, so they share them.
+    // They never touch the task then: there's no index left for them to take.
+    struct Batch
+    {
+        std::atomic<int> nextTask { 0 }, remaining { 0 };
+        int numTasks = 0;
+        juce::WaitableEvent finished;
+    };
+
+    auto batch = std::make_shared<Batch>();
+    batch->numTasks = numTasks;
+    batch->remaining = numTasks;
+
+    auto work = [batch, &task]
+    {
+        for (int i = batch->nextTask++; i < batch->numTasks; i = batch->nextTask++)
+        {
+            task(i);
+
+            if (--batch->remaining == 0)
+                batch->finished.signal();
+        }
+    };
+
+    auto numHelpers = juce::jmin(threadPool.getNumThreads() - 1, numTasks - 1);
+
+    for (int i = 0; i < numHelpers; ++i)
+        threadPool.addJob(work);
+
+    work();
+    batch->finished.wait();
+}
@@ -0,0 +1,504 @@
+/*
+ ==============================================================================
+
+ Spectrum matching: fits the EQ so a target recording sounds like a reference.
+
+ ==============================================================================
+ */
+
+#include "SpectrumMatcher.h"
+#include "RunInParallel.h"
+
+namespace
+{
+    double nextGaussian(juce::Random& random)
+    {
+        // Box-Muller
+        auto u = juce::jmax(1.0e-12, random.nextDouble());
+        return std::sqrt(-2.0 * std::log(u)) * std::cos(juce::MathConstants<double>::twoPi * random.nextDouble());
+    }
+
+    // RMS of the residuals once their mean (a level difference the EQ can't and shouldn't fix) is removed
+    double getRmsAroundMean(const std::vector<double>& residuals)
+    {
+        if (residuals.empty())
+            return 0.0;
+
+        auto mean = std::accumulate(residuals.begin(), residuals.end(), 0.0) / (double) residuals.size();
+        auto sumOfSquares = 0.0;
+
+        for (auto residual : residuals)
+            sumOfSquares += (residual - mean) * (residual - mean);
+
+        return std::sqrt(sumOfSquares / (double) residuals.size());
+    }
+
+    constexpr int numSlopes = 4;
+    constexpr double bandsPerOctave = 6.0;
+    constexpr double lowestBand = 25.0, highestBand = 16000.0;
+
+    // bands where either file is this far below its loudest band hold nothing worth matching
+    constexpr double noiseFloorDecibels = 90.0;
+
+    // Past this, how much deeper a cut goes doesn't matter (and the spectra can't measure it well anyway),
+    // so both the wanted and the candidate's response are clamped to it.
+    constexpr double cutDepthDecibels = -30.0;
+}
+
+//==============================================================================
+WelchSpectrum::WelchSpectrum(int fftOrder)
+    : fftSize(1 << fftOrder),
+      hopSize(fftSize / 2),
+      fft(fftOrder),
+      window((size_t) fftSize, juce::dsp::WindowingFunction<float>::hann, false),
+      frame((size_t) fftSize, 0.f),
+      fftData((size_t) (2 * fftSize), 0.f),
+      powerSum((size_t) (fftSize / 2 + 1), 0.0)
+{
+}
+
+void WelchSpectrum::push(const float* samples, int numSamples)
+{
+    while (numSamples > 0)
+    {
+        auto numToCopy = juce::jmin(numSamples, fftSize - numBuffered);
+        std::copy_n(samples, numToCopy, frame.data() + numBuffered);
+
+        numBuffered += numToCopy;
+        samples += numToCopy;
+        numSamples -= numToCopy;
+
+        if (numBuffered == fftSize)
+        {
+            analyseFrame();
+
+            // keep the second half: it's the first half of the next frame
+            std::copy(frame.begin() + hopSize, frame.end(), frame.begin());
+            numBuffered = fftSize - hopSize;
+        }
+    }
+}
+
+void WelchSpectrum::analyseFrame()
+{
+    std::copy(frame.begin(), frame.end(), fftData.begin());
+    window.multiplyWithWindowingTable(fftData.data(), (size_t) fftSize);
+    fft.performFrequencyOnlyForwardTransform(fftData.data());
+
+    for (size_t k = 0; k < powerSum.size(); ++k)
+        powerSum[k] += (double) fftData[k] * (double) fftData[k];
+
+    ++numFrames;
+}
+
+double WelchSpectrum::getBandDecibels(double lowFrequency, double highFrequency, double sampleRate) const
+{
+    auto binWidth = sampleRate / fftSize;
+    auto lastBin = (int) powerSum.size() - 1;
+
+    auto firstBin = juce::jlimit(0, lastBin, (int) std::ceil(lowFrequency / binWidth));
+    auto endBin = juce::jlimit(0, lastBin + 1, (int) std::ceil(highFrequency / binWidth));
+
+    if (endBin <= firstBin)
+    {
+        firstBin = juce::jlimit(0, lastBin, juce::roundToInt(0.5 * (lowFrequency + highFrequency) / binWidth));
+        endBin = firstBin + 1;
+    }
+
+    auto sum = 0.0;
+
+    for (auto k = firstBin; k < endBin; ++k)
+        sum += powerSum[(size_t) k];
+
+    auto meanPower = sum / ((endBin - firstBin) * juce::jmax(1, numFrames));
+    return 10.0 * std::log10(meanPower + 1.0e-30);
+}
+
+//==============================================================================
+juce::String SpectrumMatcher::Result::toString() const
+{
+    if (! succeeded)
+        return "Spectrum match failed: " + errorMessage;
+
+    auto slopeText = [](int slope) { return juce::String(12 * (slope + 1)) + " dB/Oct"; };
+
+    return "Low Cut " + juce::String(chainSettings.lowCutFreq, 1) + " Hz " + slopeText(chainSettings.lowCutSlope)
+           + ", Peak " + juce::String(chainSettings.peakFreq, 1) + " Hz " + juce::String(chainSettings.peakGainInDecibels, 2)
+           + " dB Q " + juce::String(chainSettings.peakQuality, 2)
+           + ", High Cut " + juce::String(chainSettings.highCutFreq, 1) + " Hz " + slopeText(chainSettings.highCutSlope)
+           + "; error " + juce::String(flatErrorDecibels, 2) + " dB -> " + juce::String(fittedErrorDecibels, 2)
+           + " dB (" + juce::String(numEvaluations) + " evaluations)";
+}
+
+SpectrumMatcher::SpectrumMatcher(SimpleeqAudioProcessor& processor)
+    : audioProcessor(processor)
+{
+    // nothing running yet
+    finished.signal();
+}
+
+SpectrumMatcher::~SpectrumMatcher()
+{
+    shouldCancel = true;
+    finished.wait();
+}
+
+void SpectrumMatcher::start(const juce::File& referenceFile, const juce::File& targetFile,
+                            std::function<void(const Result&)> onFinished, Options options)
+{
+    JUCE_ASSERT_MESSAGE_THREAD
+
+    if (running.exchange(true))
+        return;
+
+    // everything the job needs from the processor is read here, on the message thread
+    auto currentSettings = getChainSettings(audioProcessor.apvts);
+    auto sampleRate = audioProcessor.getSampleRate() > 0 ? audioProcessor.getSampleRate() : 48000.0;
+
+    ParameterRanges ranges;
+    auto getRange = [this](const char* parameterID, juce::NormalisableRange<float>& range)
+    {
+        if (auto* parameter = audioProcessor.apvts.getParameter(parameterID))
+            range = parameter->getNormalisableRange();
+    };
+
+    getRange("lowcutfreq", ranges.lowCutFreq);
+    getRange("highcutfreq", ranges.highCutFreq);
+    getRange("peakfreq", ranges.peakFreq);
+    getRange("peakgain", ranges.peakGain);
+    getRange("peakquality", ranges.peakQuality);
+
+    if (threadPool == nullptr)
+        threadPool = std::make_unique<juce::SharedResourcePointer<juce::ThreadPool>>();
+
+    shouldCancel = false;
+    finished.reset();
+
+    juce::WeakReference<SpectrumMatcher> weakThis(this);
+
+    threadPool->get().addJob([this, weakThis, referenceFile, targetFile, options, currentSettings, ranges, sampleRate, onFinished]
+    {
+        auto result = run(referenceFile, targetFile, options, currentSettings, ranges, sampleRate);
+
+        juce::MessageManager::callAsync([weakThis, result, onFinished, applyResult = options.applyResult]
+        {
+            if (auto* matcher = weakThis.get())
+            {
+                if (result.succeeded && applyResult)
+                    matcher->applyToParameters(result.chainSettings);
+
+                if (onFinished)
+                    onFinished(result);
+            }
+        });
+
+        running = false;
+        finished.signal();
+    });
+}
+
+void SpectrumMatcher::start(const juce::File& referenceFile, const juce::File& targetFile,
+                            std::function<void(const Result&)> onFinished)
+{
+    start(referenceFile, targetFile, std::move(onFinished), Options());
+}
+
+bool SpectrumMatcher::analyseFile(const juce::File& file, WelchSpectrum& spectrum, double& fileSampleRate) const
+{
+    juce::AudioFormatManager formatManager;
+    formatManager.registerBasicFormats();
+
+    std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(file));
+
+    if (reader == nullptr || reader->sampleRate <= 0)
+        return false;
+
+    fileSampleRate = reader->sampleRate;
+
+    // read in blocks and mix down to mono, so a file of any length takes the same memory
+    constexpr int blockSize = 1 << 16;
+    juce::AudioBuffer<float> buffer(juce::jmax(1, (int) reader->numChannels), blockSize);
+
+    for (juce::int64 position = 0; position < reader->lengthInSamples && ! shouldCancel; position += blockSize)
+    {
+        auto numSamples = (int) juce::jmin((juce::int64) blockSize, reader->lengthInSamples - position);
+        reader->read(&buffer, 0, numSamples, position, true, true);
+
+        for (int channel = 1; channel < buffer.getNumChannels(); ++channel)
+            buffer.addFrom(0, 0, buffer, channel, 0, numSamples);
+
+        spectrum.push(buffer.getReadPointer(0), numSamples);
+    }
+
+    return spectrum.getNumFrames() > 0;
+}
+
+double SpectrumMatcher::getErrorDecibels(const ChainSettings& chainSettings, const std::vector<double>& bandFrequencies,
+                                         const std::vector<double>& wantedDecibels, double sampleRate)
+{
+    // the same coefficients updateFilters() would set up for these settings
+    auto peakCoefficients = makePeakFilter(chainSettings, sampleRate);
+    auto lowCutCoefficients = makeLowCutFilter(chainSettings, sampleRate);
+    auto highCutCoefficients = makeHighCutFilter(chainSettings, sampleRate);
+
+    std::vector<double> residuals(bandFrequencies.size());
+
+    for (size_t i = 0; i < bandFrequencies.size(); ++i)
+    {
+        auto frequency = bandFrequencies[i];
+        auto magnitude = peakCoefficients->getMagnitudeForFrequency(frequency, sampleRate);
+
+        for (auto* section : lowCutCoefficients)
+            magnitude *= section->getMagnitudeForFrequency(frequency, sampleRate);
+
+        for (auto* section : highCutCoefficients)
+            magnitude *= section->getMagnitudeForFrequency(frequency, sampleRate);
+
+        residuals[i] = juce::jmax(cutDepthDecibels, wantedDecibels[i]) - juce::Decibels::gainToDecibels(magnitude, cutDepthDecibels);
+    }
+
+    return getRmsAroundMean(residuals);
+}
+
+SpectrumMatcher::Result SpectrumMatcher::run(const juce::File& referenceFile, const juce::File& targetFile, const Options& options,
+                                             const ChainSettings& currentSettings, const ParameterRanges& ranges, double sampleRate)
+{
+    Result result;
+
+    WelchSpectrum referenceSpectrum(options.fftOrder), targetSpectrum(options.fftOrder);
+    double referenceSampleRate = 0, targetSampleRate = 0;
+
+    if (! analyseFile(referenceFile, referenceSpectrum, referenceSampleRate))
+    {
+        result.errorMessage = "Couldn't read " + referenceFile.getFullPathName();
+        return result;
+    }
+
+    if (! analyseFile(targetFile, targetSpectrum, targetSampleRate))
+    {
+        result.errorMessage = "Couldn't read " + targetFile.getFullPathName();
+        return result;
+    }
+
+    // 1/6 octave bands, up to what both files and the plugin's sample rate can hold
+    auto topFrequency = 0.45 * juce::jmin(referenceSampleRate, targetSampleRate, sampleRate);
+    auto halfBand = std::pow(2.0, 0.5 / bandsPerOctave);
+
+    std::vector<double> allFrequencies, referenceDecibels, targetDecibels;
+
+    for (auto centre = lowestBand; centre <= highestBand && centre * halfBand < topFrequency; centre *= halfBand * halfBand)
+    {
+        allFrequencies.push_back(centre);
+        referenceDecibels.push_back(referenceSpectrum.getBandDecibels(centre / halfBand, centre * halfBand, referenceSampleRate));
+        targetDecibels.push_back(targetSpectrum.getBandDecibels(centre / halfBand, centre * halfBand, targetSampleRate));
+    }
+
+    auto referenceFloor = *std::max_element(referenceDecibels.begin(), referenceDecibels.end()) - noiseFloorDecibels;
+    auto targetFloor = *std::max_element(targetDecibels.begin(), targetDecibels.end()) - noiseFloorDecibels;
+
+    std::vector<double> bandFrequencies, wantedDecibels;
+
+    for (size_t i = 0; i < allFrequencies.size(); ++i)
+    {
+        if (referenceDecibels[i] > referenceFloor && targetDecibels[i] > targetFloor)
+        {
+            bandFrequencies.push_back(allFrequencies[i]);
+            wantedDecibels.push_back(referenceDecibels[i] - targetDecibels[i]);
+        }
+    }
+
+    if (bandFrequencies.size() < 3)
+    {
+        result.errorMessage = "Not enough signal to compare";
+        return result;
+    }
+
+    result.flatErrorDecibels = getRmsAroundMean(wantedDecibels);
+
+    //==============================================================================
+    // Cross-entropy search. The continuous parameters are searched in their normalised ranges, so the
+    // frequencies are spread like they are on the knobs. Except the gain: its knob is skewed so far that
+    // 0 dB sits near the top of the normalised range, and draws around it would nearly all be deep cuts,
+    // so it's searched linearly in dB.
+    //
+    // The peak can stand in for a cut (a wide dip at 20 Hz looks a lot like a low cut), so a single search
+    // easily settles there. Several independent searches run side by side instead, their peaks starting
+    // spread over the frequency range, and the best candidate any of them finds wins. All their
+    // candidates of a generation are scored in one parallel batch.
+    enum Dimension { LowCutFreq, HighCutFreq, PeakFreq, PeakGain, PeakQuality, numDimensions };
+
+    struct Candidate
+    {
+        std::array<double, numDimensions> position {};
+        int lowCutSlope = 0, highCutSlope = 0;
+        double error = 0;
+    };
+
+    struct Search
+    {
+        std::array<double, numDimensions> mean {}, deviation {};
+        std::array<double, numSlopes> lowCutSlopeChances {}, highCutSlopeChances {};
+    };
+
+    auto toChainSettings = [&](const Candidate& candidate)
+    {
+        // design and topology stay as they are: the fit is for the filters that will actually run
+        auto settings = currentSettings;
+        settings.lowCutFreq = ranges.lowCutFreq.convertFrom0to1((float) candidate.position[LowCutFreq]);
+        settings.highCutFreq = ranges.highCutFreq.convertFrom0to1((float) candidate.position[HighCutFreq]);
+        settings.peakFreq = ranges.peakFreq.convertFrom0to1((float) candidate.position[PeakFreq]);
+        settings.peakGainInDecibels = juce::jmap((float) candidate.position[PeakGain], ranges.peakGain.start, ranges.peakGain.end);
+        settings.peakQuality = ranges.peakQuality.convertFrom0to1((float) candidate.position[PeakQuality]);
+        settings.lowCutSlope = candidate.lowCutSlope;
+        settings.highCutSlope = candidate.highCutSlope;
+        return settings;
+    };
+
+    auto numSearches = juce::jmax(1, options.numSearches);
+    auto populationSize = juce::jmax(2, options.populationSize);
+    auto numElite = juce::jlimit(1, populationSize, options.numEliteCandidates);
+
+    // every search starts from a flat EQ (cuts out of the way, no peak gain), with its peak somewhere else
+    std::vector<Search> searches((size_t) numSearches);
+
+    for (size_t i = 0; i < searches.size(); ++i)
+    {
+        auto& search = searches[i];
+        search.mean = { 0.0, 1.0,
+                        (i + 0.5) / (double) numSearches,
+                        (double) juce::jmap(0.f, ranges.peakGain.start, ranges.peakGain.end, 0.f, 1.f),
+                        (double) ranges.peakQuality.convertTo0to1(juce::jlimit(ranges.peakQuality.start, ranges.peakQuality.end, 1.f)) };
+        search.deviation.fill(0.3);
+        search.lowCutSlopeChances.fill(1.0 / numSlopes);
+        search.highCutSlopeChances.fill(1.0 / numSlopes);
+    }
+
+    auto pickSlope = [](juce::Random& random, const std::array<double, numSlopes>& chances)
+    {
+        auto value = random.nextDouble();
+
+        for (int slope = 0; slope < numSlopes - 1; ++slope)
+        {
+            value -= chances[(size_t) slope];
+
+            if (value < 0)
+                return slope;
+        }
+
+        return numSlopes - 1;
+    };
+
+    // how far each generation moves toward its elite
+    constexpr double learningRate = 0.7;
+    constexpr double minimumDeviation = 0.002;
+
+    juce::Random random(options.seed);
+    std::vector<Candidate> population((size_t) (numSearches * populationSize));
+
+    Candidate best;
+    best.position = searches.front().mean;
+    best.error = getErrorDecibels(toChainSettings(best), bandFrequencies, wantedDecibels, sampleRate);
+
+    auto& pool = threadPool->get();
+
+    for (int generation = 0; generation < options.numGenerations; ++generation)
+    {
+        if (shouldCancel)
+        {
+            result.errorMessage = "Cancelled";
+            return result;
+        }
+
+        // drawing is cheap and uses one Random, so it stays on this thread; scoring is what runs in parallel
+        for (size_t i = 0; i < population.size(); ++i)
+        {
+            const auto& search = searches[i / (size_t) populationSize];
+            auto& candidate = population[i];
+
+            for (size_t d = 0; d < numDimensions; ++d)
+                candidate.position[d] = juce::jlimit(0.0, 1.0, search.mean[d] + search.deviation[d] * nextGaussian(random));
+
+            candidate.lowCutSlope = pickSlope(random, search.lowCutSlopeChances);
+            candidate.highCutSlope = pickSlope(random, search.highCutSlopeChances);
+        }
+
+        runInParallel(pool, (int) population.size(), [&](int i)
+        {
+            auto& candidate = population[(size_t) i];
+            candidate.error = getErrorDecibels(toChainSettings(candidate), bandFrequencies, wantedDecibels, sampleRate);
+        });
+
+        result.numEvaluations += (int) population.size();
+
+        for (size_t s = 0; s < searches.size(); ++s)
+        {
+            auto& search = searches[s];
+            auto first = population.begin() + (std::ptrdiff_t) (s * (size_t) populationSize);
+
+            std::partial_sort(first, first + numElite, first + populationSize,
+                              [](const Candidate& a, const Candidate& b) { return a.error < b.error; });
+
+            if (first->error < best.error)
+                best = *first;
+
+            // move the distribution toward the elite
+            std::array<double, numDimensions> eliteMean {}, eliteDeviation {};
+            std::array<double, numSlopes> eliteLowCutSlopes {}, eliteHighCutSlopes {};
+
+            for (auto candidate = first; candidate != first + numElite; ++candidate)
+            {
+                for (size_t d = 0; d < numDimensions; ++d)
+                    eliteMean[d] += candidate->position[d] / numElite;
+
+                eliteLowCutSlopes[(size_t) candidate->lowCutSlope] += 1.0 / numElite;
+                eliteHighCutSlopes[(size_t) candidate->highCutSlope] += 1.0 / numElite;
+            }
+
+            for (auto candidate = first; candidate != first + numElite; ++candidate)
+                for (size_t d = 0; d < numDimensions; ++d)
+                    eliteDeviation[d] += juce::square(candidate->position[d] - eliteMean[d]) / numElite;
+
+            for (size_t d = 0; d < numDimensions; ++d)
+            {
+                search.mean[d] = learningRate * eliteMean[d] + (1.0 - learningRate) * search.mean[d];
+                search.deviation[d] = juce::jmax(minimumDeviation,
+                                                 learningRate * std::sqrt(eliteDeviation[d]) + (1.0 - learningRate) * search.deviation[d]);
+            }
+
+            for (size_t slope = 0; slope < numSlopes; ++slope)
+            {
+                search.lowCutSlopeChances[slope] = learningRate * eliteLowCutSlopes[slope] + (1.0 - learningRate) * search.lowCutSlopeChances[slope];
+                search.highCutSlopeChances[slope] = learningRate * eliteHighCutSlopes[slope] + (1.0 - learningRate) * search.highCutSlopeChances[slope];
+            }
+        }
+    }
+
+    result.succeeded = true;
+    result.chainSettings = toChainSettings(best);
+    result.fittedErrorDecibels = best.error;
+    return result;
+}
+
+void SpectrumMatcher::applyToParameters(const ChainSettings& chainSettings)
+{
+    JUCE_ASSERT_MESSAGE_THREAD
+
+    // set like the knobs do, so the host sees a normal edit of each parameter
+    auto setParameter = [this](const char* parameterID, float value)
+    {
+        if (auto* parameter = audioProcessor.apvts.getParameter(parameterID))
+        {
+            parameter->beginChangeGesture();
+            parameter->setValueNotifyingHost(parameter->convertTo0to1(value));
+            parameter->endChangeGesture();
+        }
+    };
+
+    setParameter("lowcutfreq", chainSettings.lowCutFreq);
+    setParameter("highcutfreq", chainSettings.highCutFreq);
+    setParameter("peakfreq", chainSettings.peakFreq);
+    setParameter("peakgain", chainSettings.peakGainInDecibels);
+    setParameter("peakquality", chainSettings.peakQuality);
+    setParameter("lowcutslope", (float) chainSettings.lowCutSlope);
+    setParameter("highcutslope", (float) chainSettings.highCutSlope);
+}
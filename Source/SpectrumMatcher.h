@@ -0,0 +1,143 @@
+/*
+ ==============================================================================
+
+ Spectrum matching: fits the EQ so a target recording sounds like a reference.
+
+ ==============================================================================
+ */
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "PluginProcessor.h"
+
+/*
+ Long-term average power spectrum of a stream, by Welch's method: Hann-windowed frames with 50% overlap,
+ the power of every frame added up. Samples can be pushed in blocks of any size, and memory use doesn't
+ depend on how long the stream is, so whole files can go through it.
+ */
+class WelchSpectrum
+{
+    public:
+    explicit WelchSpectrum(int fftOrder = 12);
+
+    void push(const float* samples, int numSamples);
+
+    int getNumFrames() const noexcept { return numFrames; }
+    int getFftSize() const noexcept { return fftSize; }
+
+    // Mean power in [lowFrequency, highFrequency), in dB (relative, since only differences matter).
+    // Bands narrower than a bin use the nearest bin.
+    double getBandDecibels(double lowFrequency, double highFrequency, double sampleRate) const;
+
+    private:
+    int fftSize, hopSize;
+    juce::dsp::FFT fft;
+    juce::dsp::WindowingFunction<float> window;
+
+    std::vector<float> frame, fftData;
+    std::vector<double> powerSum;
+    int numBuffered = 0, numFrames = 0;
+
+    void analyseFrame();
+};
+
+/*
+ Finds the ChainSettings that make a target recording's long-term spectrum closest to a reference's, and
+ applies them to the processor's parameters.
+
+     SpectrumMatcher matcher(processor);
+     matcher.start(referenceFile, targetFile, [](const SpectrumMatcher::Result& result) { DBG(result.toString()); });
+
+ The editor's "Match..." button does this with two file choosers (see SimpleeqAudioProcessorEditor::Controls).
+
+ The spectra are compared in 1/6 octave bands. The EQ we want is reference minus target in dB; the
+ error of a candidate is the RMS difference between that and the candidate's response, ignoring the
+ overall level (the EQ has no output gain).
+
+ The fit is a cross-entropy search: each generation draws a population of candidates around the current
+ best guess (peak freq/gain/Q and the cut frequencies in the parameters' normalised ranges, the slopes
+ from per-choice probabilities), scores them, and moves the distribution toward the best few. A few of
+ these searches run side by side from different starting points, so one stuck in a local minimum doesn't
+ decide the result. The scoring of a generation is spread over a ThreadPool shared by all instances (with
+ the coordinating job helping), and the candidates' responses are computed with the same coefficient
+ functions updateFilters() uses.
+
+ start() returns straight away: reading the files and fitting run on the pool, never on the message or
+ audio thread. The result comes back on the message thread, where it is set like any other parameter
+ change (gestures and all), so the host records it like an edit. The audio thread just sees new parameter
+ values in its next updateFilters().
+ */
+class SpectrumMatcher
+{
+    public:
+    struct Options
+    {
+        int fftOrder = 14;              // 16384 points: bins narrow enough for 1/6 octave bands from 25 Hz
+        int numSearches = 4;            // independent searches, run side by side
+        int populationSize = 64;        // candidates per search and generation
+        int numEliteCandidates = 8;
+        int numGenerations = 30;
+        juce::int64 seed = 1;
+        bool applyResult = true; // set the parameters when done
+    };
+
+    struct Result
+    {
+        bool succeeded = false;
+        juce::String errorMessage;
+
+        ChainSettings chainSettings;
+
+        // RMS difference between the wanted and the actual correction, before (flat EQ) and after, in dB
+        double flatErrorDecibels = 0, fittedErrorDecibels = 0;
+        int numEvaluations = 0;
+
+        juce::String toString() const;
+    };
+
+    explicit SpectrumMatcher(SimpleeqAudioProcessor& processor);
+
+    // Cancels a running match and waits for it to stop.
+    ~SpectrumMatcher();
+
+    // Call from the message thread. onFinished is called on the message thread, unless the matcher has been
+    // deleted by then. Ignored while a match is still running.
+    void start(const juce::File& referenceFile, const juce::File& targetFile,
+               std::function<void(const Result&)> onFinished, Options options);
+
+    void start(const juce::File& referenceFile, const juce::File& targetFile,
+               std::function<void(const Result&)> onFinished = {});
+
+    bool isRunning() const noexcept { return running.load(); }
+
+    // The error of a ChainSettings against a wanted correction, both at the given band frequencies.
+    // Exposed so the fit can be checked without audio files.
+    static double getErrorDecibels(const ChainSettings& chainSettings, const std::vector<double>& bandFrequencies,
+                                   const std::vector<double>& wantedDecibels, double sampleRate);
+
+    private:
+    struct ParameterRanges
+    {
+        juce::NormalisableRange<float> lowCutFreq { 20.f, 20000.f }, highCutFreq { 20.f, 20000.f }, peakFreq { 20.f, 20000.f },
+                                       peakGain { -24.f, 24.f }, peakQuality { 0.1f, 10.f };
+    };
+
+    SimpleeqAudioProcessor& audioProcessor;
+
+    // only created once a match is started, so instances that never match don't start any threads
+    std::unique_ptr<juce::SharedResourcePointer<juce::ThreadPool>> threadPool;
+
+    std::atomic<bool> running { false }, shouldCancel { false };
+    juce::WaitableEvent finished { true };
+
+    Result run(const juce::File& referenceFile, const juce::File& targetFile, const Options& options,
+               const ChainSettings& currentSettings, const ParameterRanges& ranges, double sampleRate);
+
+    bool analyseFile(const juce::File& file, WelchSpectrum& spectrum, double& fileSampleRate) const;
+
+    void applyToParameters(const ChainSettings& chainSettings);
+
+    JUCE_DECLARE_WEAK_REFERENCEABLE(SpectrumMatcher)
+    JUCE_DECLARE_NON_COPYABLE(SpectrumMatcher)
+};
@@ -0,0 +1,74 @@
+/*
+ ==============================================================================
+
+ Topology-preserving (TPT) state variable filter sections.
+
+ ==============================================================================
+ */
+
+#include "SvfFilter.h"
+
+SvfCoefficients SvfCoefficients::fromAnalog(double g, double k, double m0, double m1, double m2)
+{
+    // everything is computed in double, only the final values are rounded to float
+    auto a1 = 1.0 / (1.0 + g * (g + k));
+    auto a2 = g * a1;
+    auto a3 = g * a2;
+
+    SvfCoefficients c;
+    c.g = static_cast<float>(g);
+    c.k = static_cast<float>(k);
+    c.m0 = static_cast<float>(m0);
+    c.m1 = static_cast<float>(m1);
+    c.m2 = static_cast<float>(m2);
+    c.a1 = static_cast<float>(a1);
+    c.a2 = static_cast<float>(a2);
+    c.a3 = static_cast<float>(a3);
+    return c;
+}
+
+SvfCoefficients SvfCoefficients::fromBiquad(const std::array<double, 6>& biquad)
+{
+    // Undo the bilinear transform: the state variable filter realises
+    //     H(s) = (m0 (s^2 + k s + 1) + m1 s + m2) / (s^2 + k s + 1),  s = (1/g) (1 - z^-1) / (1 + z^-1)
+    // Evaluating the digital polynomials at z = 1 and z = -1 gives g, k and the analog numerator directly.
+    auto b0 = biquad[0] / biquad[3], b1 = biquad[1] / biquad[3], b2 = biquad[2] / biquad[3];
+    auto a1 = biquad[4] / biquad[3], a2 = biquad[5] / biquad[3];
+
+    auto atDC = 1.0 + a1 + a2;
+    auto atNyquist = 1.0 - a1 + a2;
+
+    jassert(atDC > 0.0 && atNyquist > 0.0); // unstable poles can't be mapped back
+
+    auto g = std::sqrt(atDC / atNyquist);
+    auto k = 2.0 * (1.0 - a2) / std::sqrt(atDC * atNyquist);
+
+    // analog numerator c2 s^2 + c1 s + c0
+    auto c0 = (b0 + b1 + b2) / atDC;
+    auto c2 = (b0 - b1 + b2) / atNyquist;
+    auto c1 = 2.0 * (b0 - b2) / (atNyquist * g);
+
+    return fromAnalog(g, k, c2, c1 - k * c2, c0 - c2);
+}
+
+SvfCoefficients SvfCoefficients::makeLowPass(double sampleRate, double frequency, double Q)
+{
+    auto g = std::tan(juce::MathConstants<double>::pi * frequency / sampleRate);
+    return fromAnalog(g, 1.0 / Q, 0.0, 0.0, 1.0);
+}
+
+SvfCoefficients SvfCoefficients::makeHighPass(double sampleRate, double frequency, double Q)
+{
+    auto g = std::tan(juce::MathConstants<double>::pi * frequency / sampleRate);
+    auto k = 1.0 / Q;
+    return fromAnalog(g, k, 1.0, -k, -1.0);
+}
+
+SvfCoefficients SvfCoefficients::makePeakFilter(double sampleRate, double frequency, double Q, double gainFactor)
+{
+    // RBJ peak: (s^2 + s A/Q + 1) / (s^2 + s/(A Q) + 1), i.e. the input plus a scaled band pass
+    auto A = std::sqrt(juce::jmax(0.0, gainFactor));
+    auto g = std::tan(juce::MathConstants<double>::pi * frequency / sampleRate);
+    auto k = 1.0 / (A * Q);
+    return fromAnalog(g, k, 1.0, k * (A * A - 1.0), 0.0);
+}
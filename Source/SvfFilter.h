@@ -0,0 +1,125 @@
+/*
+ ==============================================================================
+
+ Topology-preserving (TPT) state variable filter sections.
+
+ ==============================================================================
+ */
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/*
+ IIR::Filter runs each biquad in direct form, where the coefficients are the polynomial coefficients
+ b0..a2. For a low cut near 20 Hz at 192 kHz the poles sit right next to the unit circle: a1 is almost
+ -2 and a2 almost 1, and the cutoff is set by 1 + a1 + a2, which is around 4e-7, only a few float steps.
+ The filter then lands at the wrong frequency, and rounding noise in the state gets amplified by the
+ huge low-frequency gain of the recursion.
+
+ The TPT state variable filter (Zavalishin, Simper) has the same transfer function as the bilinear
+ biquad, but it is parameterised by
+     g = tan(pi f / fs)     (the prewarped cutoff, small but with full float precision)
+     k = 1 / Q              (damping)
+ and its two states are integrators of the band and low pass signals, which stay well scaled however
+ low the cutoff. Any second-order response is a mix of the input and those two signals:
+     out = m0 * input + m1 * bandpass + m2 * lowpass
+ so it stays accurate in float where the direct form would need double.
+ */
+struct SvfCoefficients
+{
+    // defaults are a pass-through
+    float g { 0.f }, k { 2.f };
+    float m0 { 1.f }, m1 { 0.f }, m2 { 0.f };
+
+    // derived from g and k, precomputed for the per-sample loop
+    float a1 { 1.f }, a2 { 0.f }, a3 { 0.f };
+
+    static SvfCoefficients fromAnalog(double g, double k, double m0, double m1, double m2);
+
+    // Converts a digital biquad { b0, b1, b2, a0, a1, a2 } (e.g. a MatchedFilterDesign section computed in
+    // double) to the same response in state variable form. The poles must be stable.
+    static SvfCoefficients fromBiquad(const std::array<double, 6>& biquad);
+
+    // The same responses as IIR::Coefficients::makeLowPass/makeHighPass/makePeakFilter.
+    static SvfCoefficients makeLowPass(double sampleRate, double frequency, double Q);
+    static SvfCoefficients makeHighPass(double sampleRate, double frequency, double Q);
+    static SvfCoefficients makePeakFilter(double sampleRate, double frequency, double Q, double gainFactor);
+};
+
+/*
+ A drop-in for IIR::Filter inside a ProcessorChain: one channel, a public coefficients member that
+ updateCoefficients() can write to, and the same prepare/reset/process interface.
+ */
+class SvfFilter
+{
+    public:
+    SvfCoefficients coefficients;
+
+    void prepare(const juce::dsp::ProcessSpec&) noexcept { reset(); }
+    void reset() noexcept { ic1eq = ic2eq = 0.f; }
+
+    float processSample(float v0) noexcept
+    {
+        const auto& c = coefficients;
+
+        float v1, v2;
+        tick(v0, v1, v2);
+
+        return c.m0 * v0 + c.m1 * v1 + c.m2 * v2;
+    }
+
+    // One update, every output: the low, band and high pass of the input (m0..m2 are ignored). They all come
+    // from the same state, so a section that is needed as both a low and a high pass only has to run once.
+    void processSample(float v0, float& lowPass, float& bandPass, float& highPass) noexcept
+    {
+        tick(v0, bandPass, lowPass);
+        highPass = v0 - coefficients.k * bandPass - lowPass;
+    }
+
+    template<typename ProcessContext>
+    void process(const ProcessContext& context) noexcept
+    {
+        const auto& inputBlock = context.getInputBlock();
+        auto& outputBlock = context.getOutputBlock();
+
+        jassert(inputBlock.getNumChannels() == 1 && outputBlock.getNumChannels() == 1);
+
+        if (context.isBypassed)
+        {
+            if (context.usesSeparateInputAndOutputBlocks())
+                outputBlock.copyFrom(inputBlock);
+
+            return;
+        }
+
+        auto numSamples = inputBlock.getNumSamples();
+        auto* src = inputBlock.getChannelPointer(0);
+        auto* dst = outputBlock.getChannelPointer(0);
+
+        for (size_t i = 0; i < numSamples; ++i)
+            dst[i] = processSample(src[i]);
+
+        snapToZero();
+    }
+
+    void snapToZero() noexcept
+    {
+        juce::dsp::util::snapToZero(ic1eq);
+        juce::dsp::util::snapToZero(ic2eq);
+    }
+
+    private:
+    float ic1eq { 0.f }, ic2eq { 0.f };
+
+    void tick(float v0, float& v1, float& v2) noexcept
+    {
+        const auto& c = coefficients;
+
+        auto v3 = v0 - ic2eq;
+        v1 = c.a1 * ic1eq + c.a2 * v3;        // band pass
+        v2 = ic2eq + c.a2 * ic1eq + c.a3 * v3; // low pass
+        ic1eq = 2.f * v1 - ic1eq;
+        ic2eq = 2.f * v2 - ic2eq;
+    }
+};
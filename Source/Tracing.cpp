@@ -0,0 +1,117 @@
+/*
+ ==============================================================================
+
+ Opt-in tracing of the audio and message thread hot paths.
+
+ ==============================================================================
+ */
+
+#include "Tracing.h"
+
+#if SIMPLEEQ_ENABLE_TRACING
+
+namespace Tracing
+{
+    namespace
+    {
+        constexpr int maxThreads = 32;
+
+        // Every slot is reserved up front (static storage, so only the pages a thread actually writes get
+        // touched), and a thread claims a free one by flipping its flag. A thread hands its slot back when
+        // it exits, so hosts that keep starting new worker or offline render threads don't run out. The
+        // events stay in the slot until its next owner overwrites them, so they can still be dumped.
+        std::array<ThreadBuffer, maxThreads> threadBuffers;
+        std::array<std::atomic<bool>, maxThreads> claimed;
+        std::atomic<juce::uint64> numDroppedEvents { 0 };
+
+        ThreadBuffer* claimThreadBuffer() noexcept
+        {
+            for (size_t index = 0; index < (size_t) maxThreads; ++index)
+            {
+                auto expected = false;
+
+                if (! claimed[index].load(std::memory_order_relaxed)
+                    && claimed[index].compare_exchange_strong(expected, true, std::memory_order_acquire))
+                    return &threadBuffers[index];
+            }
+
+            return nullptr;
+        }
+
+        // Owned by each thread; its destructor runs when the thread exits.
+        struct ThreadSlot
+        {
+            ThreadBuffer* buffer = nullptr;
+
+            ~ThreadSlot()
+            {
+                if (buffer != nullptr)
+                    claimed[(size_t) (buffer - threadBuffers.data())].store(false, std::memory_order_release);
+            }
+        };
+    }
+
+    ThreadBuffer* getThreadBuffer() noexcept
+    {
+        thread_local ThreadSlot slot;
+
+        // a thread that found the pool full tries again, in case another thread has exited since
+        if (slot.buffer == nullptr)
+            slot.buffer = claimThreadBuffer();
+
+        return slot.buffer;
+    }
+
+    void countDroppedEvent() noexcept
+    {
+        numDroppedEvents.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    bool writeChromeTrace(const juce::File& file)
+    {
+        const auto ticksPerMicrosecond = (double) juce::Time::getHighResolutionTicksPerSecond() / 1.0e6;
+
+        juce::String json;
+        json << "{\"traceEvents\":[\n";
+
+        bool first = true;
+
+        for (int index = 0; index < maxThreads; ++index)
+        {
+            const auto* buffer = &threadBuffers[(size_t) index];
+            auto numWritten = buffer->numWritten.load(std::memory_order_acquire);
+            auto oldest = numWritten > (juce::uint64) ThreadBuffer::capacity ? numWritten - ThreadBuffer::capacity : 0;
+
+            for (auto i = oldest; i < numWritten; ++i)
+            {
+                const auto& event = buffer->events[(size_t) (i % ThreadBuffer::capacity)];
+
+                if (! first)
+                    json << ",\n";
+
+                first = false;
+
+                json << "{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << index
+                     << ",\"ts\":" << juce::String((double) event.startTicks / ticksPerMicrosecond, 3)
+                     << ",\"dur\":" << juce::String((double) (event.endTicks - event.startTicks) / ticksPerMicrosecond, 3) << "}";
+            }
+        }
+
+        // events recorded while every slot was taken
+        json << "\n],\"otherData\":{\"droppedEvents\":" << juce::String((juce::int64) numDroppedEvents.load()) << "}}\n";
+
+        return file.replaceWithText(json);
+    }
+
+    bool writeChromeTraceToEnvironmentPath()
+    {
+        auto path = juce::SystemStats::getEnvironmentVariable("SIMPLEEQ_TRACE_FILE", {});
+
+        if (path.isEmpty())
+            return false;
+
+        return writeChromeTrace(juce::File::getCurrentWorkingDirectory().getChildFile(path));
+    }
+}
+
+#endif
@@ -0,0 +1,107 @@
+/*
+ ==============================================================================
+
+ Opt-in tracing of the audio and message thread hot paths.
+
+ ==============================================================================
+ */
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/*
+ When the audio drops out, we want to know where the time went: processBlock, updateFilters,
+ setStateInformation, or the editor's timerCallback/paint hogging the message thread.
+
+ Put SIMPLEEQ_TRACE_SCOPE("name") at the top of a function and every call gets recorded as a
+ begin/duration event. Each thread writes into its own fixed-size ring buffer, taken from a pool that
+ is reserved up front (and handed back when the thread exits), so recording never locks and the plugin
+ never allocates for it. The one exception is the C runtime: the first traced call on a thread touches a
+ thread_local, and in a plugin that the host loads at runtime, glibc (__tls_get_addr) and macOS
+ (tlv_allocate_and_initialize_for_key) may allocate that thread's TLS block right then. Tracing is a
+ debugging aid, so we live with that one allocation per thread. Tracing::writeChromeTrace() dumps
+ everything to a JSON file that chrome://tracing and ui.perfetto.dev can open.
+
+ To get a trace out of a host, set the SIMPLEEQ_TRACE_FILE environment variable to a file path before
+ starting it: every SimpleeqAudioProcessor writes the trace there when it is destroyed (so when the
+ plugin is removed or the host quits).
+
+ Tracing is only compiled in when SIMPLEEQ_ENABLE_TRACING is set to 1 (e.g. in the Projucer's
+ preprocessor definitions). Otherwise the macro expands to nothing.
+ */
+
+#ifndef SIMPLEEQ_ENABLE_TRACING
+ #define SIMPLEEQ_ENABLE_TRACING 0
+#endif
+
+#if SIMPLEEQ_ENABLE_TRACING
+
+namespace Tracing
+{
+    struct Event
+    {
+        const char* name;   // must be a string literal, we only keep the pointer
+        juce::int64 startTicks;
+        juce::int64 endTicks;
+    };
+
+    // Single writer (the owning thread), read only when dumping.
+    struct ThreadBuffer
+    {
+        static constexpr int capacity = 1 << 14; // oldest events get overwritten
+
+        std::array<Event, capacity> events;
+        std::atomic<juce::uint64> numWritten { 0 };
+
+        void push(const char* name, juce::int64 startTicks, juce::int64 endTicks) noexcept
+        {
+            auto index = numWritten.load(std::memory_order_relaxed);
+            events[(size_t) (index % capacity)] = { name, startTicks, endTicks };
+            numWritten.store(index + 1, std::memory_order_release);
+        }
+    };
+
+    // The calling thread's buffer: the first call on a thread claims a free one from the pool, and the
+    // thread hands it back when it exits. Returns nullptr while every buffer is taken, in which case the
+    // event is dropped and counted (the dump reports the count as "droppedEvents").
+    ThreadBuffer* getThreadBuffer() noexcept;
+    void countDroppedEvent() noexcept;
+
+    // Writes every buffered event as a Chrome trace ("traceEvents" JSON). Call it from anywhere,
+    // but expect events recorded while it runs to be missing or torn.
+    bool writeChromeTrace(const juce::File& file);
+
+    // Writes the trace to the path in the SIMPLEEQ_TRACE_FILE environment variable (relative paths start
+    // from the working directory). Does nothing when the variable isn't set.
+    bool writeChromeTraceToEnvironmentPath();
+
+    struct ScopedEvent
+    {
+        explicit ScopedEvent(const char* eventName) noexcept
+            : name(eventName), startTicks(juce::Time::getHighResolutionTicks()) {}
+
+        ~ScopedEvent() noexcept
+        {
+            if (auto* buffer = getThreadBuffer())
+                buffer->push(name, startTicks, juce::Time::getHighResolutionTicks());
+            else
+                countDroppedEvent();
+        }
+
+        const char* name;
+        juce::int64 startTicks;
+
+        JUCE_DECLARE_NON_COPYABLE(ScopedEvent)
+    };
+}
+
+ #define SIMPLEEQ_TRACE_CONCAT_(a, b) a##b
+ #define SIMPLEEQ_TRACE_CONCAT(a, b) SIMPLEEQ_TRACE_CONCAT_(a, b)
+ #define SIMPLEEQ_TRACE_SCOPE(name) const Tracing::ScopedEvent SIMPLEEQ_TRACE_CONCAT(traceScope_, __LINE__) (name)
+
+#else
+
+ #define SIMPLEEQ_TRACE_SCOPE(name)
+
+#endif
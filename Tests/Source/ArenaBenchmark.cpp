@@ -0,0 +1,218 @@
+/*
+ ==============================================================================
+
+ Throughput and cache misses of the chains vs. the chain arena with many instances.
+
+ ==============================================================================
+ */
+
+#include "ArenaBenchmark.h"
+#include "TestHelpers.h"
+
+#if JUCE_LINUX
+ #include <linux/perf_event.h>
+ #include <sys/ioctl.h>
+ #include <sys/syscall.h>
+ #include <unistd.h>
+#endif
+
+namespace
+{
+    // Counts the calling thread's last level cache misses between start() and stop().
+    struct CacheMissCounter
+    {
+        CacheMissCounter()
+        {
+           #if JUCE_LINUX
+            perf_event_attr attributes {};
+            attributes.size = sizeof(attributes);
+            attributes.type = PERF_TYPE_HARDWARE;
+            attributes.config = PERF_COUNT_HW_CACHE_MISSES;
+            attributes.disabled = 1;
+            attributes.exclude_kernel = 1;
+            attributes.exclude_hv = 1;
+
+            fd = (int) syscall(__NR_perf_event_open, &attributes, 0, -1, -1, 0);
+           #endif
+        }
+
+        ~CacheMissCounter()
+        {
+           #if JUCE_LINUX
+            if (fd >= 0)
+                close(fd);
+           #endif
+        }
+
+        bool isAvailable() const { return fd >= 0; }
+
+        void start()
+        {
+           #if JUCE_LINUX
+            if (isAvailable())
+            {
+                ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+                ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+            }
+           #endif
+        }
+
+        juce::int64 stop()
+        {
+            juce::int64 count = -1;
+
+           #if JUCE_LINUX
+            if (isAvailable())
+            {
+                ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+
+                if (read(fd, &count, sizeof(count)) != (ssize_t) sizeof(count))
+                    count = -1;
+            }
+           #endif
+
+            return count;
+        }
+
+        int fd = -1;
+
+        JUCE_DECLARE_NON_COPYABLE(CacheMissCounter)
+    };
+
+    struct Instance
+    {
+        MonoChain leftChain, rightChain;
+        ChainArena arena;
+    };
+
+    void setUp(Instance& instance, const ChainSettings& chainSettings, const juce::dsp::ProcessSpec& spec)
+    {
+        // the same steps as prepareToPlay() and updateFilters()
+        auto coefficients = makeChainCoefficients(chainSettings, spec.sampleRate);
+
+        for (auto* chain : { &instance.leftChain, &instance.rightChain })
+        {
+            chain->prepare(spec);
+            updateChain(*chain, coefficients, chainSettings);
+        }
+
+        instance.arena.allocate(ChainArena::maxChannels);
+
+        for (int channel = 0; channel < ChainArena::maxChannels; ++channel)
+            updateChain(instance.arena, channel, coefficients, chainSettings);
+    }
+
+    // Runs process(instance, block) for every instance, numRounds times, and returns the seconds taken.
+    // Every call gets a fresh copy of the same noise, so the signal never decays into denormals or builds
+    // up from one instance to the next, and both variants process exactly the same input.
+    template<typename ProcessFunction>
+    double runRounds(std::vector<std::unique_ptr<Instance>>& instances, const juce::AudioBuffer<float>& noise,
+                     juce::AudioBuffer<float>& scratch, int numRounds, CacheMissCounter& counter,
+                     juce::int64& cacheMisses, ProcessFunction&& process)
+    {
+        auto processInstance = [&](Instance& instance)
+        {
+            scratch.makeCopyOf(noise, true);
+            process(instance, scratch);
+        };
+
+        // one untimed round, so both variants start from the same (cold, for many instances) cache state
+        for (auto& instance : instances)
+            processInstance(*instance);
+
+        counter.start();
+        auto start = juce::Time::getHighResolutionTicks();
+
+        for (int round = 0; round < numRounds; ++round)
+            for (auto& instance : instances)
+                processInstance(*instance);
+
+        auto seconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start);
+        cacheMisses = counter.stop();
+        return seconds;
+    }
+}
+
+ArenaBenchmark::Result ArenaBenchmark::run(const Options& options)
+{
+    jassert(options.numInstances > 0 && options.numRounds > 0 && options.blockSize > 0);
+
+    juce::dsp::ProcessSpec spec;
+    spec.maximumBlockSize = (juce::uint32) options.blockSize;
+    spec.numChannels = 1;
+    spec.sampleRate = options.sampleRate;
+
+    juce::Random random(1);
+
+    // every stage active, and slightly different settings per instance, like a real session
+    std::vector<std::unique_ptr<Instance>> instances;
+
+    for (int i = 0; i < options.numInstances; ++i)
+    {
+        auto lowCutFreq = 20.f + 200.f * random.nextFloat();
+        auto highCutFreq = 8000.f + 8000.f * random.nextFloat();
+        auto peakFreq = 200.f + 4000.f * random.nextFloat();
+        auto peakGainInDecibels = 12.f * random.nextFloat() - 6.f;
+        auto chainSettings = TestHelpers::makeChainSettings(lowCutFreq, Slope_48, peakFreq, peakGainInDecibels, 1.f, highCutFreq, Slope_48);
+
+        instances.push_back(std::make_unique<Instance>());
+        setUp(*instances.back(), chainSettings, spec);
+    }
+
+    auto noise = TestHelpers::makeNoise(2, options.blockSize, random);
+    juce::AudioBuffer<float> scratch(2, options.blockSize);
+
+    // like processBlock(), in case the filters' tails still reach denormals
+    juce::ScopedNoDenormals noDenormals;
+
+    CacheMissCounter counter;
+    juce::int64 chainMisses = -1, arenaMisses = -1;
+
+    // before: processBlock()'s old stereo path
+    auto chainSeconds = runRounds(instances, noise, scratch, options.numRounds, counter, chainMisses, [](Instance& instance, juce::AudioBuffer<float>& b)
+    {
+        juce::dsp::AudioBlock<float> block(b);
+        auto leftBlock = block.getSingleChannelBlock(0);
+        auto rightBlock = block.getSingleChannelBlock(1);
+        juce::dsp::ProcessContextReplacing<float> leftContext(leftBlock);
+        juce::dsp::ProcessContextReplacing<float> rightContext(rightBlock);
+        instance.leftChain.process(leftContext);
+        instance.rightChain.process(rightContext);
+    });
+
+    // after: the arena, which updateFilters() designs into directly
+    auto arenaSeconds = runRounds(instances, noise, scratch, options.numRounds, counter, arenaMisses, [](Instance& instance, juce::AudioBuffer<float>& b)
+    {
+        instance.arena.process(0, b.getWritePointer(0), b.getNumSamples());
+        instance.arena.process(1, b.getWritePointer(1), b.getNumSamples());
+    });
+
+    auto numBlocks = (double) options.numInstances * options.numRounds;
+    auto numSamples = numBlocks * options.blockSize * 2;
+
+    Result result;
+    result.numInstances = options.numInstances;
+    result.chainNanosecondsPerSample = chainSeconds * 1.0e9 / numSamples;
+    result.arenaNanosecondsPerSample = arenaSeconds * 1.0e9 / numSamples;
+
+    if (chainMisses >= 0 && arenaMisses >= 0)
+    {
+        result.chainCacheMissesPerBlock = (double) chainMisses / numBlocks;
+        result.arenaCacheMissesPerBlock = (double) arenaMisses / numBlocks;
+    }
+
+    return result;
+}
+
+juce::String ArenaBenchmark::Result::toString() const
+{
+    juce::String text;
+
+    text << numInstances << " instances\n"
+         << "chains: " << juce::String(chainNanosecondsPerSample, 2) << " ns/sample, "
+         << juce::String(chainCacheMissesPerBlock, 1) << " cache misses/block\n"
+         << "arena:  " << juce::String(arenaNanosecondsPerSample, 2) << " ns/sample, "
+         << juce::String(arenaCacheMissesPerBlock, 1) << " cache misses/block\n";
+
+    return text;
+}
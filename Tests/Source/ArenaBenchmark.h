@@ -0,0 +1,48 @@
+/*
+ ==============================================================================
+
+ Throughput and cache misses of the chains vs. the chain arena with many instances.
+
+ ==============================================================================
+ */
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/*
+ One instance's filters fit in L1 easily, so the cost of the chains' pointer chasing only shows up when
+ a session has many instances and each processBlock() starts with a cold cache. This sets up
+ numInstances stereo "instances" (two MonoChains plus a ChainArena each, with 48 dB/Oct cuts so every
+ stage is active), then processes one block per instance in turn, round after round, once through the
+ chains (what processBlock() did before) and once through the arenas (what it does now).
+
+ Throughput is reported in nanoseconds per sample per channel. Cache misses come from the CPU's
+ hardware counter through perf_event_open() on Linux, and are reported as -1 elsewhere or when the
+ kernel doesn't allow it (see /proc/sys/kernel/perf_event_paranoid). "simple-eq-tests --benchmarks"
+ runs it with the default options.
+ */
+struct ArenaBenchmark
+{
+    struct Options
+    {
+        int numInstances = 2000;
+        int numRounds = 50;
+        int blockSize = 64;
+        double sampleRate = 48000.0;
+    };
+
+    struct Result
+    {
+        int numInstances = 0;
+
+        double chainNanosecondsPerSample = 0, arenaNanosecondsPerSample = 0;
+
+        // per processed block, -1 when the counter isn't available
+        double chainCacheMissesPerBlock = -1, arenaCacheMissesPerBlock = -1;
+
+        juce::String toString() const;
+    };
+
+    static Result run(const Options& options);
+};
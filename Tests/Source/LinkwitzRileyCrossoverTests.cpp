@@ -0,0 +1,109 @@
+/*
+ ==============================================================================
+
+ The three bands of the LinkwitzRileyCrossover sum back to a flat magnitude.
+
+ ==============================================================================
+ */
+
+#include <JuceHeader.h>
+#include "../../Source/PluginProcessor.h"
+
+/*
+ A Linkwitz-Riley crossover only promises a flat sum (low + mid + high is an all pass), so that's what
+ these tests check, for LR4 and LR8, set up the way the plugin does it (designCrossover()). The impulse
+ response of the summed bands is measured at log spaced frequencies from 10 Hz to just below Nyquist.
+
+ A crossover that just passed its input through to one band would sum flat too, so each band also has to
+ be 6 dB down at its split frequency, where the Linkwitz-Riley bands meet.
+ */
+class LinkwitzRileyCrossoverTests : public juce::UnitTest
+{
+    public:
+    LinkwitzRileyCrossoverTests() : juce::UnitTest("LinkwitzRileyCrossover", "simple-eq") {}
+
+    void runTest() override
+    {
+        for (auto order : { LinkwitzRileyCrossover::Order_LR4, LinkwitzRileyCrossover::Order_LR8 })
+        {
+            auto orderName = juce::String(order == LinkwitzRileyCrossover::Order_LR8 ? "LR8" : "LR4");
+
+            beginTest(orderName + ": the bands sum to a flat magnitude");
+            {
+                for (auto sampleRate : { 44100.0, 96000.0 })
+                    for (auto splits : { std::make_pair(200.f, 4000.f), std::make_pair(20.f, 20000.f), std::make_pair(1000.f, 1000.f) })
+                    {
+                        auto bands = getImpulseResponses(order, splits.first, splits.second, sampleRate);
+                        std::vector<double> sum(bands.low.size());
+
+                        for (size_t n = 0; n < sum.size(); ++n)
+                            sum[n] = bands.low[n] + bands.mid[n] + bands.high[n];
+
+                        double worstDeviationDb = 0;
+
+                        for (double f = 10.0; f < 0.999 * sampleRate / 2; f *= 1.05)
+                            worstDeviationDb = juce::jmax(worstDeviationDb, std::abs(getMagnitudeDb(sum, f, sampleRate)));
+
+                        expectLessOrEqual(worstDeviationDb, 0.01,
+                                          "splits at " + juce::String(splits.first) + " and " + juce::String(splits.second)
+                                          + " Hz, " + juce::String(sampleRate) + " Hz");
+                    }
+            }
+
+            beginTest(orderName + ": the bands meet 6 dB down at the split frequencies");
+            {
+                constexpr double sampleRate = 48000.0;
+                auto bands = getImpulseResponses(order, 200.f, 4000.f, sampleRate);
+                auto halfDb = juce::Decibels::gainToDecibels(0.5);
+
+                expectWithinAbsoluteError(getMagnitudeDb(bands.low, 200.0, sampleRate), halfDb, 0.1, "low band at 200 Hz");
+                expectWithinAbsoluteError(getMagnitudeDb(bands.high, 4000.0, sampleRate), halfDb, 0.1, "high band at 4 kHz");
+
+                // and each band passes its own range
+                expectWithinAbsoluteError(getMagnitudeDb(bands.low, 20.0, sampleRate), 0.0, 0.1, "low band at 20 Hz");
+                expectWithinAbsoluteError(getMagnitudeDb(bands.mid, 900.0, sampleRate), 0.0, 0.1, "mid band at 900 Hz");
+                expectWithinAbsoluteError(getMagnitudeDb(bands.high, 20000.0, sampleRate), 0.0, 0.1, "high band at 20 kHz");
+            }
+        }
+    }
+
+    private:
+    struct Bands
+    {
+        std::vector<double> low, mid, high;
+    };
+
+    // Long enough for the slowest case here (an LR8 split at 20 Hz) to ring out below float precision.
+    static constexpr int impulseLength = 1 << 16;
+
+    static Bands getImpulseResponses(LinkwitzRileyCrossover::Order order, float firstFrequency, float secondFrequency, double sampleRate)
+    {
+        LinkwitzRileyCrossover crossover;
+        crossover.reset();
+        designCrossover(crossover, firstFrequency, secondFrequency, order, sampleRate);
+
+        std::vector<float> input((size_t) impulseLength, 0.f), low(input.size()), mid(input.size()), high(input.size());
+        input[0] = 1.f;
+
+        crossover.process(0, input.data(), low.data(), mid.data(), high.data(), impulseLength);
+
+        return { { low.begin(), low.end() }, { mid.begin(), mid.end() }, { high.begin(), high.end() } };
+    }
+
+    static double getMagnitudeDb(const std::vector<double>& impulseResponse, double frequency, double sampleRate)
+    {
+        std::complex<double> response;
+        auto step = std::polar(1.0, -juce::MathConstants<double>::twoPi * frequency / sampleRate);
+        std::complex<double> z = 1.0;
+
+        for (auto sample : impulseResponse)
+        {
+            response += sample * z;
+            z *= step;
+        }
+
+        return juce::Decibels::gainToDecibels(std::abs(response), -400.0);
+    }
+};
+
+static LinkwitzRileyCrossoverTests linkwitzRileyCrossoverTests;
@@ -0,0 +1,72 @@
+/*
+ ==============================================================================
+
+ Console runner for the simple-eq tests and benchmarks.
+
+ ==============================================================================
+ */
+
+#include <JuceHeader.h>
+#include "StressHarness.h"
+#include "TopologyComparison.h"
+#include "StartupBenchmark.h"
+#include "ArenaBenchmark.h"
+#include "MonoKernelBenchmark.h"
+#include "SegmentedRenderBenchmark.h"
+
+/*
+ The plugin target only ships the EQ. Everything that checks or measures it is built into this console
+ app instead (simple-eq-tests.jucer), on top of the same plugin sources:
+
+     simple-eq-tests                  runs the unit tests, and exits with 1 if any of them failed
+     simple-eq-tests --benchmarks     also runs every benchmark and prints its report
+ */
+int main(int argc, char* argv[])
+{
+    // The processors and editors need a message manager. This thread becomes the message thread, which is
+    // where StartupBenchmark has to create its editors.
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    juce::ArgumentList arguments(argc, argv);
+
+    juce::UnitTestRunner runner;
+    runner.setAssertOnFailure(false);
+    runner.runTestsInCategory("simple-eq");
+
+    int numFailures = 0;
+
+    for (int i = 0; i < runner.getNumResults(); ++i)
+        numFailures += runner.getResult(i)->failures;
+
+    if (arguments.containsOption("--benchmarks"))
+    {
+        struct Benchmark
+        {
+            const char* name;
+            std::function<juce::String()> run;
+        };
+
+        const Benchmark benchmarks[]
+        {
+            { "automation stress", [] { return AutomationStressHarness::run({}).toString(); } },
+            { "topology comparison", []
+                {
+                    ChainSettings settings;
+                    settings.lowCutFreq = 20.f;
+                    settings.lowCutSlope = Slope_48;
+                    settings.highCutFreq = 20000.f;
+                    settings.peakFreq = 750.f;
+                    return TopologyComparison::run(settings, 192000.0).toString();
+                } },
+            { "startup", [] { return StartupBenchmark::run({}).toString(); } },
+            { "chain arena", [] { return ArenaBenchmark::run({}).toString(); } },
+            { "mono kernel", [] { return MonoKernelBenchmark::run({}).toString(); } },
+            { "segmented render", [] { return SegmentedRenderBenchmark::run({}).toString(); } }
+        };
+
+        for (const auto& benchmark : benchmarks)
+            std::cout << "== " << benchmark.name << "\n" << benchmark.run() << std::endl;
+    }
+
+    return numFailures > 0 ? 1 : 0;
+}
@@ -0,0 +1,186 @@
+/*
+ ==============================================================================
+
+ Accuracy of the matched filter designs against their analog prototypes.
+
+ ==============================================================================
+ */
+
+#include <JuceHeader.h>
+#include "../../Source/MatchedFilterDesign.h"
+
+/*
+ MatchedFilterDesign promises to follow the analog response up to Nyquist. These tests hold it to that:
+ every section is swept from 10 Hz to just below Nyquist and compared (in dB) with the analog prototype
+ it was designed from, at the sample rates and settings the plugin actually uses.
+
+ The bounds are the measured worst cases with a bit of headroom, so a regression in the design shows up
+ as a failure instead of a slightly different curve. The matching is least exact for sections tuned close
+ to Nyquist (about 0.6 dB for a 16 kHz cut at 44.1 kHz), and exact at the points it solves for.
+ */
+class MatchedFilterDesignTests : public juce::UnitTest
+{
+    public:
+    MatchedFilterDesignTests() : juce::UnitTest("MatchedFilterDesign", "simple-eq") {}
+
+    void runTest() override
+    {
+        const double sampleRates[] { 44100.0, 48000.0, 96000.0 };
+
+        beginTest("Peaks hit the analog magnitude at DC, the centre frequency and Nyquist");
+        {
+            for (auto sampleRate : sampleRates)
+                for (auto frequency : { 100.0, 1000.0, 10000.0, 16000.0 })
+                    for (auto Q : { 0.1, 1.0, 10.0 })
+                        for (auto gainDb : { -24.0, 24.0 })
+                        {
+                            auto section = MatchedFilterDesign::makePeakFilter(sampleRate, frequency, Q, juce::Decibels::decibelsToGain(gainDb));
+                            auto analog = [&](double f) { return getAnalogPeakDb(f, frequency, Q, gainDb); };
+
+                            for (auto f : { 0.0, frequency, sampleRate / 2 })
+                                expectWithinAbsoluteError(getDigitalDb(section, f, sampleRate), analog(f), 0.01,
+                                                          "peak at " + juce::String(frequency) + " Hz, f = " + juce::String(f));
+                        }
+        }
+
+        beginTest("Butterworth cascades follow the analog passband");
+        {
+            // Everything the analog filter passes within 3 dB, for every slope the cut filters offer.
+            for (auto sampleRate : sampleRates)
+                for (auto frequency : { 20.0, 1000.0, 5000.0, 10000.0 })
+                    for (auto order : { 2, 4, 6, 8 })
+                        for (auto highPass : { false, true })
+                            expectLessOrEqual(getCascadeErrorDb(sampleRate, frequency, order, highPass, -3.0), 0.25,
+                                              describeCut(sampleRate, frequency, order, highPass));
+        }
+
+        beginTest("High pass cascades follow the analog response down to -40 dB");
+        {
+            for (auto sampleRate : sampleRates)
+                for (auto frequency : { 20.0, 1000.0, 5000.0, 10000.0, 16000.0 })
+                    for (auto order : { 2, 4, 6, 8 })
+                        expectLessOrEqual(getCascadeErrorDb(sampleRate, frequency, order, true, -40.0), 0.75,
+                                          describeCut(sampleRate, frequency, order, true));
+        }
+
+        beginTest("Butterworth sections stay close to the analog response near Nyquist");
+        {
+            // The 12 dB/oct slope is a single section with Q = 1/sqrt(2). A 16 kHz cut is the hardest case
+            // for the matching: 0.6 dB of error just above the cutoff at 44.1 kHz, 0.7 dB at 48 kHz, and
+            // about 1 dB further down the low pass skirt at 96 kHz.
+            for (auto sampleRate : sampleRates)
+                for (auto highPass : { false, true })
+                {
+                    expectLessOrEqual(getCascadeErrorDb(sampleRate, 16000.0, 2, highPass, -12.0), 0.8,
+                                      describeCut(sampleRate, 16000.0, 2, highPass));
+                    expectLessOrEqual(getCascadeErrorDb(sampleRate, 16000.0, 2, highPass, -40.0), 1.25,
+                                      describeCut(sampleRate, 16000.0, 2, highPass));
+                }
+        }
+
+        beginTest("Peaks at +-24 dB follow the analog response");
+        {
+            for (auto sampleRate : sampleRates)
+                for (auto frequency : { 20.0, 100.0, 1000.0, 5000.0, 10000.0, 16000.0 })
+                    for (auto Q : { 0.1, 0.3, 0.71, 1.0, 3.0, 10.0 })
+                        for (auto gainDb : { -24.0, 24.0 })
+                        {
+                            auto section = MatchedFilterDesign::makePeakFilter(sampleRate, frequency, Q, juce::Decibels::decibelsToGain(gainDb));
+
+                            double worstErrorDb = 0;
+
+                            forEachFrequency(sampleRate, [&](double f)
+                            {
+                                auto error = std::abs(getDigitalDb(section, f, sampleRate) - getAnalogPeakDb(f, frequency, Q, gainDb));
+                                worstErrorDb = juce::jmax(worstErrorDb, error);
+                            });
+
+                            // 24 dB of boost or cut at 16 kHz and 44.1 kHz leaves the least room for matching
+                            auto tolerance = frequency > 10000.0 ? 2.5 : 1.0;
+
+                            expectLessOrEqual(worstErrorDb, tolerance,
+                                              "peak at " + juce::String(frequency) + " Hz, Q " + juce::String(Q)
+                                              + ", " + juce::String(gainDb) + " dB, " + juce::String(sampleRate) + " Hz");
+                        }
+        }
+    }
+
+    private:
+    // Log sweep from 10 Hz to just below Nyquist, 1% apart.
+    template<typename Function>
+    static void forEachFrequency(double sampleRate, Function&& function)
+    {
+        for (double f = 10.0; f < 0.999 * sampleRate / 2; f *= 1.01)
+            function(f);
+    }
+
+    static double getDigitalDb(const std::array<double, 6>& section, double frequency, double sampleRate)
+    {
+        auto z = std::polar(1.0, -juce::MathConstants<double>::twoPi * frequency / sampleRate);
+        auto numerator = section[0] + section[1] * z + section[2] * z * z;
+        auto denominator = section[3] + section[4] * z + section[5] * z * z;
+
+        return juce::Decibels::gainToDecibels(std::abs(numerator / denominator), -400.0);
+    }
+
+    // The analog prototypes, with w the frequency relative to the centre frequency.
+    static double getAnalogCutDb(double frequency, double cutoff, double Q, bool highPass)
+    {
+        auto w = frequency / cutoff;
+        auto response = std::complex<double>(highPass ? -w * w : 1.0) / std::complex<double>(1.0 - w * w, w / Q);
+
+        return juce::Decibels::gainToDecibels(std::abs(response), -400.0);
+    }
+
+    static double getAnalogPeakDb(double frequency, double centre, double Q, double gainDb)
+    {
+        // The RBJ-style peak that the bilinear makePeakFilter is also built from: sqrt(gain) above and
+        // below the poles, so the boost at the centre is the full gain.
+        auto w = frequency / centre;
+        auto A = std::sqrt(juce::Decibels::decibelsToGain(gainDb));
+        auto response = std::complex<double>(1.0 - w * w, w * A / Q) / std::complex<double>(1.0 - w * w, w / (A * Q));
+
+        return juce::Decibels::gainToDecibels(std::abs(response), -400.0);
+    }
+
+    // Worst error of a whole cut filter (all its sections), wherever the analog response is above floorDb.
+    static double getCascadeErrorDb(double sampleRate, double cutoff, int order, bool highPass, double floorDb)
+    {
+        std::vector<std::array<double, 6>> sections;
+        std::vector<double> Qs;
+
+        for (int i = 0; i < order / 2; ++i)
+        {
+            auto Q = MatchedFilterDesign::getButterworthSectionQ(order, i);
+            Qs.push_back(Q);
+            sections.push_back(highPass ? MatchedFilterDesign::makeHighPass(sampleRate, cutoff, Q)
+                                        : MatchedFilterDesign::makeLowPass(sampleRate, cutoff, Q));
+        }
+
+        double worstErrorDb = 0;
+
+        forEachFrequency(sampleRate, [&](double f)
+        {
+            double digitalDb = 0, analogDb = 0;
+
+            for (size_t i = 0; i < sections.size(); ++i)
+            {
+                digitalDb += getDigitalDb(sections[i], f, sampleRate);
+                analogDb += getAnalogCutDb(f, cutoff, Qs[i], highPass);
+            }
+
+            if (analogDb > floorDb)
+                worstErrorDb = juce::jmax(worstErrorDb, std::abs(digitalDb - analogDb));
+        });
+
+        return worstErrorDb;
+    }
+
+    static juce::String describeCut(double sampleRate, double cutoff, int order, bool highPass)
+    {
+        return juce::String(highPass ? "high pass" : "low pass") + " order " + juce::String(order)
+             + " at " + juce::String(cutoff) + " Hz, " + juce::String(sampleRate) + " Hz";
+    }
+};
+
+static MatchedFilterDesignTests matchedFilterDesignTests;
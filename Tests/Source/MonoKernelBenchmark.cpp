@@ -0,0 +1,87 @@
+/*
+ ==============================================================================
+
+ Mono throughput of the MonoBlockKernel vs. the MonoChain it mirrors.
+
+ ==============================================================================
+ */
+
+#include "MonoKernelBenchmark.h"
+#include "TestHelpers.h"
+
+namespace
+{
+    // Copies the input into output (untimed), then runs process(samples, numSamples) over it one host
+    // block at a time, and returns the fastest of numRuns in seconds.
+    template<typename ProcessFunction>
+    double timeInBlocks(const juce::AudioBuffer<float>& input, juce::AudioBuffer<float>& output, int blockSize,
+                        int numRuns, ProcessFunction&& process)
+    {
+        double fastest = std::numeric_limits<double>::max();
+
+        for (int run = 0; run < numRuns; ++run)
+        {
+            output.makeCopyOf(input, true);
+            auto* samples = output.getWritePointer(0);
+
+            auto start = juce::Time::getHighResolutionTicks();
+
+            for (int position = 0; position < output.getNumSamples(); position += blockSize)
+                process(samples + position, juce::jmin(blockSize, output.getNumSamples() - position));
+
+            fastest = juce::jmin(fastest, juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start));
+        }
+
+        return fastest;
+    }
+}
+
+MonoKernelBenchmark::Result MonoKernelBenchmark::run(const Options& options)
+{
+    jassert(options.seconds > 0 && options.blockSize > 0 && options.numRuns > 0);
+
+    auto chainSettings = TestHelpers::makeChainSettings(20.f, Slope_48, 750.f, 12.f, 1.f, 12000.f, Slope_48);
+
+    auto numSamples = (int) (options.seconds * options.sampleRate);
+    juce::Random random(1);
+    auto input = TestHelpers::makeNoise(1, numSamples, random);
+    juce::AudioBuffer<float> output(1, numSamples);
+
+    MonoChain chain;
+    chain.prepare({ options.sampleRate, (juce::uint32) options.blockSize, 1 });
+    updateChain(chain, chainSettings, options.sampleRate);
+
+    MonoBlockKernel kernel;
+
+    // like processBlock()
+    juce::ScopedNoDenormals noDenormals;
+
+    auto chainSeconds = timeInBlocks(input, output, options.blockSize, options.numRuns, [&](float* samples, int numBlockSamples)
+    {
+        float* channels[] { samples };
+        juce::dsp::AudioBlock<float> block(channels, 1, (size_t) numBlockSamples);
+        chain.process(juce::dsp::ProcessContextReplacing<float>(block));
+    });
+
+    auto kernelSeconds = timeInBlocks(input, output, options.blockSize, options.numRuns, [&](float* samples, int numBlockSamples)
+    {
+        kernel.updateFromChain(chain);
+        kernel.process(samples, numBlockSamples);
+    });
+
+    Result result;
+    result.chainNanosecondsPerSample = chainSeconds * 1.0e9 / numSamples;
+    result.kernelNanosecondsPerSample = kernelSeconds * 1.0e9 / numSamples;
+    return result;
+}
+
+juce::String MonoKernelBenchmark::Result::toString() const
+{
+    juce::String text;
+
+    text << "MonoChain: " << juce::String(chainNanosecondsPerSample, 2) << " ns/sample\n"
+         << "kernel:    " << juce::String(kernelNanosecondsPerSample, 2) << " ns/sample, "
+         << juce::String(chainNanosecondsPerSample / kernelNanosecondsPerSample, 2) << "x\n";
+
+    return text;
+}
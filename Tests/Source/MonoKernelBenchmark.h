@@ -0,0 +1,40 @@
+/*
+ ==============================================================================
+
+ Mono throughput of the MonoBlockKernel vs. the MonoChain it mirrors.
+
+ ==============================================================================
+ */
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/*
+ The mono path processes through a MonoBlockKernel instead of the MonoChain's IIR::Filters (see
+ MonoBlockKernel.h). This runs the same noise through both, host block by host block, with 48 dB/Oct
+ cuts so all 9 stages are active. Like processFilters(), the kernel picks up the chain's settings before
+ every block, so that cost is included.
+
+ Throughput is reported in nanoseconds per sample, the fastest of a few runs. "simple-eq-tests
+ --benchmarks" runs it with the default options.
+ */
+struct MonoKernelBenchmark
+{
+    struct Options
+    {
+        double seconds = 20.0;
+        int blockSize = 512;
+        double sampleRate = 48000.0;
+        int numRuns = 5;
+    };
+
+    struct Result
+    {
+        double chainNanosecondsPerSample = 0, kernelNanosecondsPerSample = 0;
+
+        juce::String toString() const;
+    };
+
+    static Result run(const Options& options);
+};
@@ -0,0 +1,92 @@
+/*
+ ==============================================================================
+
+ Render time of the SegmentedRenderer against the size of its thread pool.
+
+ ==============================================================================
+ */
+
+#include "SegmentedRenderBenchmark.h"
+#include "SegmentedRenderer.h"
+#include "TestHelpers.h"
+
+namespace
+{
+    // Copies the input into output, runs render(output), and returns the fastest of numRuns in seconds.
+    template<typename RenderFunction>
+    double timeRender(const juce::AudioBuffer<float>& input, juce::AudioBuffer<float>& output, int numRuns, RenderFunction&& render)
+    {
+        double fastest = std::numeric_limits<double>::max();
+
+        for (int i = 0; i < numRuns; ++i)
+        {
+            output.makeCopyOf(input, true);
+
+            auto start = juce::Time::getHighResolutionTicks();
+            render(output);
+            fastest = juce::jmin(fastest, juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start));
+        }
+
+        return fastest;
+    }
+}
+
+SegmentedRenderBenchmark::Result SegmentedRenderBenchmark::run(const Options& options)
+{
+    jassert(options.seconds > 0 && options.numRuns > 0);
+
+    auto chainSettings = TestHelpers::makeChainSettings(20.f, Slope_48, 750.f, 12.f, 1.f, 12000.f, Slope_48);
+
+    auto numSamples = (int) (options.seconds * options.sampleRate);
+    juce::Random random(1);
+    auto input = TestHelpers::makeNoise(1, numSamples, random);
+    juce::AudioBuffer<float> output(1, numSamples);
+
+    juce::ScopedNoDenormals noDenormals;
+
+    Result result;
+
+    result.serialSeconds = timeRender(input, output, options.numRuns, [&](juce::AudioBuffer<float>& buffer)
+    {
+        MonoChain chain;
+        chain.prepare({ options.sampleRate, (juce::uint32) numSamples, 1 });
+        updateChain(chain, chainSettings, options.sampleRate);
+
+        juce::dsp::AudioBlock<float> block(buffer);
+        chain.process(juce::dsp::ProcessContextReplacing<float>(block));
+    });
+
+    SegmentedRenderer renderer(chainSettings, options.sampleRate);
+    auto numCpus = juce::SystemStats::getNumCpus();
+
+    for (int numThreads = 1; ; numThreads = juce::jmin(numThreads * 2, numCpus))
+    {
+        juce::ThreadPool threadPool(numThreads);
+
+        auto seconds = timeRender(input, output, options.numRuns, [&](juce::AudioBuffer<float>& buffer)
+        {
+            renderer.process(buffer, threadPool);
+        });
+
+        result.poolSizes.add({ numThreads, seconds });
+
+        if (numThreads >= numCpus)
+            break;
+    }
+
+    return result;
+}
+
+juce::String SegmentedRenderBenchmark::Result::toString() const
+{
+    juce::String text;
+
+    text << "MonoChain:  " << juce::String(serialSeconds * 1000.0, 1) << " ms\n";
+
+    for (const auto& poolSize : poolSizes)
+        text << juce::String(poolSize.numThreads).paddedLeft(' ', 3) << " threads: "
+             << juce::String(poolSize.seconds * 1000.0, 1) << " ms, "
+             << juce::String(poolSizes.getFirst().seconds / poolSize.seconds, 2) << "x\n";
+
+    return text;
+}
@@ -0,0 +1,49 @@
+/*
+ ==============================================================================
+
+ Render time of the SegmentedRenderer against the size of its thread pool.
+
+ ==============================================================================
+ */
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/*
+ SegmentedRenderer claims close to linear scaling: the zero-state and ring-out passes split evenly over
+ the threads, and only the stitching of the segment boundaries is serial. This renders the same noise
+ (a long mono "file" through a chain with every stage active) on pools of 1, 2, 4, ... threads up to the
+ number of CPUs, with one segment per thread, and also through a MonoChain in one go, which is what the
+ segments replace.
+
+ Each time is the fastest of a few runs. The speed-up is relative to the pool with a single thread, so
+ it shows the scaling itself, not the extra work the segmenting costs (the 1 thread vs. MonoChain times
+ show that). "simple-eq-tests --benchmarks" runs it with the default options.
+ */
+struct SegmentedRenderBenchmark
+{
+    struct Options
+    {
+        double seconds = 300.0;
+        double sampleRate = 48000.0;
+        int numRuns = 3;
+    };
+
+    struct Result
+    {
+        double serialSeconds = 0;
+
+        struct PoolSize
+        {
+            int numThreads = 0;
+            double seconds = 0;
+        };
+
+        juce::Array<PoolSize> poolSizes;
+
+        juce::String toString() const;
+    };
+
+    static Result run(const Options& options);
+};
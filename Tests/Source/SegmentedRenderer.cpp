@@ -0,0 +1,215 @@
+/*
+ ==============================================================================
+
+ Parallel offline rendering of long files through a MonoChain.
+
+ ==============================================================================
+ */
+
+#include "SegmentedRenderer.h"
+#include "../../Source/RunInParallel.h"
+
+namespace
+{
+    // square matrices, row major
+    std::vector<double> multiply(const std::vector<double>& a, const std::vector<double>& b, int size)
+    {
+        std::vector<double> result(a.size(), 0.0);
+
+        for (int row = 0; row < size; ++row)
+            for (int k = 0; k < size; ++k)
+            {
+                auto factor = a[(size_t) (row * size + k)];
+
+                if (factor != 0.0)
+                    for (int column = 0; column < size; ++column)
+                        result[(size_t) (row * size + column)] += factor * b[(size_t) (k * size + column)];
+            }
+
+        return result;
+    }
+}
+
+SegmentedRenderer::SegmentedRenderer(const ChainSettings& chainSettings, double sampleRate)
+{
+    // same stages, in the same order, as a MonoChain set up by updateFilters()
+    addStages(makeLowCutFilter(chainSettings, sampleRate), chainSettings.lowCutSlope);
+    addStage(*makePeakFilter(chainSettings, sampleRate));
+    addStages(makeHighCutFilter(chainSettings, sampleRate), chainSettings.highCutSlope);
+}
+
+void SegmentedRenderer::addStages(const juce::ReferenceCountedArray<juce::dsp::IIR::Coefficients<float>>& cutCoefficients, int slope)
+{
+    // updateCutFilter() enables sections 0 ... slope
+    for (int i = 0; i <= slope; ++i)
+        addStage(*cutCoefficients[i]);
+}
+
+void SegmentedRenderer::addStage(const juce::dsp::IIR::Coefficients<float>& coefficients)
+{
+    jassert(coefficients.coefficients.size() == 5);
+
+    const auto& c = coefficients.coefficients;
+    stages.push_back({ c[0], c[1], c[2], c[3], c[4] });
+}
+
+void SegmentedRenderer::process(juce::AudioBuffer<float>& buffer, juce::ThreadPool& threadPool, int numSegments)
+{
+    for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+    {
+        auto* samples = buffer.getWritePointer(channel);
+        process(samples, samples, buffer.getNumSamples(), threadPool, numSegments);
+    }
+}
+
+void SegmentedRenderer::process(const float* input, float* output, int numSamples, juce::ThreadPool& threadPool, int numSegments)
+{
+    if (input != output)
+        std::copy(input, input + numSamples, output);
+
+    if (stages.empty() || numSamples == 0)
+        return;
+
+    if (numSegments <= 0)
+        numSegments = threadPool.getNumThreads();
+
+    auto segmentLength = (numSamples + numSegments - 1) / numSegments;
+    numSegments = (numSamples + segmentLength - 1) / segmentLength;
+
+    auto stateSize = getStateSize();
+    std::vector<double> endStates((size_t) (numSegments * stateSize));
+    std::vector<double> startStates((size_t) (numSegments * stateSize), 0.0);
+
+    auto getSegmentLength = [&](int segment) { return juce::jmin(segmentLength, numSamples - segment * segmentLength); };
+
+    // 1) zero-state response of every segment, in parallel
+    runInParallel(threadPool, numSegments, [&](int segment)
+    {
+        renderZeroState(output + segment * segmentLength, getSegmentLength(segment), endStates.data() + segment * stateSize);
+    });
+
+    // 2) stitch the segment boundaries together: the true state at the start of a segment is what the
+    //    previous segment's input left behind, plus the previous start state carried over the segment.
+    //    All segments but the last have the same length, so one transition matrix does it.
+    auto transition = getStateTransition(segmentLength);
+
+    for (int segment = 1; segment < numSegments; ++segment)
+    {
+        const auto* previousStart = startStates.data() + (segment - 1) * stateSize;
+        const auto* previousEnd = endStates.data() + (segment - 1) * stateSize;
+        auto* start = startStates.data() + segment * stateSize;
+
+        for (int row = 0; row < stateSize; ++row)
+        {
+            auto value = previousEnd[row];
+
+            for (int column = 0; column < stateSize; ++column)
+                value += transition[(size_t) (row * stateSize + column)] * previousStart[column];
+
+            start[row] = value;
+        }
+    }
+
+    // 3) add the ring-out of those start states, in parallel (the first segment starts from silence)
+    runInParallel(threadPool, numSegments - 1, [&](int index)
+    {
+        auto segment = index + 1;
+        addZeroInputResponse(output + segment * segmentLength, getSegmentLength(segment), startStates.data() + segment * stateSize);
+    });
+}
+
+void SegmentedRenderer::renderZeroState(float* samples, int numSamples, double* endState) const
+{
+    // Stage after stage, with the same arithmetic as IIR::Filter, so the first segment is bit-identical
+    // to a serial render.
+    for (size_t i = 0; i < stages.size(); ++i)
+    {
+        const auto& stage = stages[i];
+        float s0 = 0.f, s1 = 0.f;
+
+        for (int n = 0; n < numSamples; ++n)
+        {
+            auto input = samples[n];
+            auto output = input * stage.b0 + s0;
+            samples[n] = output;
+            s0 = (input * stage.b1) - (output * stage.a1) + s1;
+            s1 = (input * stage.b2) - (output * stage.a2);
+        }
+
+        endState[2 * i] = s0;
+        endState[2 * i + 1] = s1;
+    }
+}
+
+void SegmentedRenderer::addZeroInputResponse(float* samples, int numSamples, const double* startState) const
+{
+    std::vector<double> state(startState, startState + getStateSize());
+
+    // Once every state is this small the ring-out is far below what a float sample can resolve.
+    constexpr double silence = 1.0e-20;
+
+    for (int n = 0; n < numSamples; ++n)
+    {
+        samples[n] += static_cast<float>(stepWithoutInput(state.data()));
+
+        if ((n & 63) == 63
+            && std::all_of(state.begin(), state.end(), [](double s) { return std::abs(s) < silence; }))
+            break;
+    }
+}
+
+double SegmentedRenderer::stepWithoutInput(double* state) const
+{
+    // one sample of silence through the cascade, in double so the stitching doesn't add noise of its own
+    double x = 0.0;
+
+    for (size_t i = 0; i < stages.size(); ++i)
+    {
+        const auto& stage = stages[i];
+        auto& s0 = state[2 * i];
+        auto& s1 = state[2 * i + 1];
+
+        auto y = stage.b0 * x + s0;
+        s0 = stage.b1 * x - stage.a1 * y + s1;
+        s1 = stage.b2 * x - stage.a2 * y;
+        x = y;
+    }
+
+    return x;
+}
+
+std::vector<double> SegmentedRenderer::getStateTransition(int numSamples) const
+{
+    auto size = getStateSize();
+
+    // One sample of silence through the cascade is a linear map of the state. Build its matrix column by
+    // column by stepping each unit state once...
+    std::vector<double> step((size_t) (size * size), 0.0);
+
+    for (int column = 0; column < size; ++column)
+    {
+        std::vector<double> state((size_t) size, 0.0);
+        state[(size_t) column] = 1.0;
+
+        stepWithoutInput(state.data());
+
+        for (int row = 0; row < size; ++row)
+            step[(size_t) (row * size + column)] = state[(size_t) row];
+    }
+
+    // ...then raise it to numSamples by repeated squaring.
+    std::vector<double> result((size_t) (size * size), 0.0);
+
+    for (int i = 0; i < size; ++i)
+        result[(size_t) (i * size + i)] = 1.0;
+
+    for (auto n = numSamples; n > 0; n >>= 1)
+    {
+        if (n & 1)
+            result = multiply(result, step, size);
+
+        step = multiply(step, step, size);
+    }
+
+    return result;
+}
@@ -0,0 +1,73 @@
+/*
+ ==============================================================================
+
+ Parallel offline rendering of long files through a MonoChain.
+
+ ==============================================================================
+ */
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "../../Source/PluginProcessor.h"
+
+/*
+ Rendering a multi-hour recording through the EQ is a serial job: every sample needs the filter state
+ left by the previous one, so one file only ever keeps one core busy.
+
+ The filter cascade is linear though, so the output of any segment can be split in two:
+     - the zero-state response: the segment's own input, starting from silent filters
+     - the zero-input response: what the filters still "ring out" from the state the previous segments
+       left behind, with no input at all
+ The zero-state responses don't depend on each other, so every segment renders those on its own core.
+ The state at each segment boundary is then stitched together exactly, using the state transition matrix
+ of the cascade raised to the segment length, which is a tiny amount of serial work. Finally each
+ segment adds the ring-out of its start state, which only lasts until the filters have decayed below
+ float precision.
+
+ The result is the same as running the whole file through a MonoChain, up to float rounding.
+
+ It isn't part of the plugin: it lives with the tests, which check it against a serial render
+ (SegmentedRendererTests) and measure how it scales with the number of threads (SegmentedRenderBenchmark).
+ */
+class SegmentedRenderer
+{
+    public:
+    SegmentedRenderer(const ChainSettings& chainSettings, double sampleRate);
+
+    // Renders every channel of the buffer in place, with the same settings on each channel.
+    // numSegments <= 0 uses one segment per thread of the pool. The calling thread renders segments too,
+    // so this can also be called from a job on the same pool.
+    void process(juce::AudioBuffer<float>& buffer, juce::ThreadPool& threadPool, int numSegments = 0);
+
+    // Renders one channel from input to output (which may be the same pointer).
+    void process(const float* input, float* output, int numSamples, juce::ThreadPool& threadPool, int numSegments = 0);
+
+    private:
+    struct Stage
+    {
+        float b0, b1, b2, a1, a2;
+    };
+
+    // The active stages of the chain, in processing order (LowCut sections, Peak, HighCut sections).
+    std::vector<Stage> stages;
+
+    int getStateSize() const { return 2 * static_cast<int>(stages.size()); }
+
+    void addStages(const juce::ReferenceCountedArray<juce::dsp::IIR::Coefficients<float>>& cutCoefficients, int slope);
+    void addStage(const juce::dsp::IIR::Coefficients<float>& coefficients);
+
+    // zero-state render of one segment; leaves the final filter states in endState
+    void renderZeroState(float* samples, int numSamples, double* endState) const;
+
+    // adds the ring-out of startState to the segment
+    void addZeroInputResponse(float* samples, int numSamples, const double* startState) const;
+
+    // advances the state by one sample with no input, and returns the cascade's output
+    double stepWithoutInput(double* state) const;
+
+    // state transition of the whole cascade over numSamples samples of silence
+    std::vector<double> getStateTransition(int numSamples) const;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SegmentedRenderer)
+};
@@ -0,0 +1,207 @@
+/*
+ ==============================================================================
+
+ SegmentedRenderer against a serial render through a MonoChain.
+
+ ==============================================================================
+ */
+
+#include <JuceHeader.h>
+#include "SegmentedRenderer.h"
+#include "TestHelpers.h"
+
+/*
+ Splitting a file into segments must not change the result: every render here is compared with the same
+ input run through a MonoChain in one go. That covers 1 to 8 segments, more segments than samples, a
+ single sample, and pools that can't give the renderer any extra threads at all, including a call from a
+ job on the renderer's own pool.
+
+ One segment is the serial render, with the same arithmetic. With more segments, the stitched states
+ round differently from the serial float render, and a 20 Hz 48 dB/oct cut amplifies any rounding: the
+ serial float render itself is about -64 dB off a render in double precision. So instead of asking for a
+ tight match with the serial render, we check that segmenting never makes the result noticeably less accurate than
+ the serial render already is, on top of a plain -50 dB bound against the serial render.
+ */
+class SegmentedRendererTests : public juce::UnitTest
+{
+    public:
+    SegmentedRendererTests() : juce::UnitTest("SegmentedRenderer", "simple-eq") {}
+
+    void runTest() override
+    {
+        auto input = makeNoise(1 << 16);
+        auto serial = renderSerial(input);
+
+        beginTest("One segment is the serial render");
+        {
+            juce::ThreadPool threadPool(4);
+            expectLessThan(getError(serial, renderSegmented(input, threadPool, 1)), 1.0e-6);
+        }
+
+        beginTest("Is as accurate as the serial render for 2 to 8 segments");
+        {
+            juce::ThreadPool threadPool(4);
+            auto reference = renderInDouble(input);
+            auto serialError = getError(reference, serial);
+
+            for (int numSegments = 2; numSegments <= 8; ++numSegments)
+            {
+                auto segmented = renderSegmented(input, threadPool, numSegments);
+
+                expectLessThan(getError(serial, segmented), tolerance, juce::String(numSegments) + " segments");
+                expectLessThan(getError(reference, segmented), 1.5 * serialError, juce::String(numSegments) + " segments");
+            }
+
+            // one segment per thread of the pool
+            expectLessThan(getError(serial, renderSegmented(input, threadPool, 0)), tolerance, "default segments");
+        }
+
+        beginTest("Handles inputs shorter than the number of segments");
+        {
+            juce::ThreadPool threadPool(4);
+
+            for (auto numSamples : { 1, 2, 5 })
+            {
+                auto shortInput = makeNoise(numSamples);
+                expectLessThan(getError(renderSerial(shortInput), renderSegmented(shortInput, threadPool, 8)), tolerance,
+                               juce::String(numSamples) + " samples");
+            }
+        }
+
+        beginTest("Renders on a pool with a single thread");
+        {
+            juce::ThreadPool threadPool(1);
+            auto oneSample = makeNoise(1);
+
+            expectLessThan(getError(serial, renderSegmented(input, threadPool, 1)), tolerance, "1 segment");
+            expectLessThan(getError(serial, renderSegmented(input, threadPool, 4)), tolerance, "4 segments");
+            expectLessThan(getError(renderSerial(oneSample), renderSegmented(oneSample, threadPool, 1)), tolerance, "1 sample");
+        }
+
+        beginTest("Renders from a job on its own pool");
+        {
+            // The only thread of the pool is busy with the job that calls the renderer, so the calling
+            // thread has to render all the segments itself.
+            //
+            // Everything the job touches is owned by the heap, not by this test: if the render hangs, the
+            // test fails and leaks the state and the pool, instead of destroying them under a job that is
+            // still running.
+            struct JobState
+            {
+                juce::AudioBuffer<float> input, segmented;
+                juce::WaitableEvent finished;
+            };
+
+            auto state = std::make_shared<JobState>();
+            state->input = input;
+
+            auto threadPool = std::make_unique<juce::ThreadPool>(1);
+
+            threadPool->addJob([state, pool = threadPool.get()]
+            {
+                state->segmented = renderSegmented(state->input, *pool, 4);
+                state->finished.signal();
+            });
+
+            if (state->finished.wait(10000))
+            {
+                expectLessThan(getError(serial, state->segmented), tolerance);
+            }
+            else
+            {
+                expect(false, "the render never finished");
+                juce::ignoreUnused(threadPool.release());
+            }
+        }
+    }
+
+    private:
+    static constexpr double sampleRate = 48000.0;
+    static constexpr double tolerance = 3.0e-3;
+
+    static ChainSettings getSettings()
+    {
+        // A 20 Hz cut rings for a long time, so the segments really depend on each other's state.
+        return TestHelpers::makeChainSettings(20.f, Slope_48, 750.f, 12.f, 4.f, 12000.f, Slope_24);
+    }
+
+    juce::AudioBuffer<float> makeNoise(int numSamples)
+    {
+        auto random = getRandom();
+        return TestHelpers::makeNoise(1, numSamples, random);
+    }
+
+    // the same steps as prepareToPlay() and updateFilters(), and the whole input as one block
+    static juce::AudioBuffer<float> renderSerial(const juce::AudioBuffer<float>& input)
+    {
+        MonoChain chain;
+        chain.prepare({ sampleRate, (juce::uint32) input.getNumSamples(), 1 });
+        updateChain(chain, getSettings(), sampleRate);
+
+        juce::AudioBuffer<float> output(input);
+        juce::dsp::AudioBlock<float> block(output);
+        chain.process(juce::dsp::ProcessContextReplacing<float>(block));
+
+        return output;
+    }
+
+    static juce::AudioBuffer<float> renderSegmented(const juce::AudioBuffer<float>& input, juce::ThreadPool& threadPool, int numSegments)
+    {
+        juce::AudioBuffer<float> output(input);
+
+        SegmentedRenderer renderer(getSettings(), sampleRate);
+        renderer.process(output, threadPool, numSegments);
+
+        return output;
+    }
+
+    // The serial render again, with the same (float) coefficients but in double precision.
+    static juce::AudioBuffer<float> renderInDouble(const juce::AudioBuffer<float>& input)
+    {
+        auto chainSettings = getSettings();
+
+        juce::ReferenceCountedArray<juce::dsp::IIR::Coefficients<float>> sections;
+        auto lowCut = makeLowCutFilter(chainSettings, sampleRate);
+        auto highCut = makeHighCutFilter(chainSettings, sampleRate);
+
+        for (int i = 0; i <= chainSettings.lowCutSlope; ++i)
+            sections.add(lowCut[i]);
+
+        sections.add(makePeakFilter(chainSettings, sampleRate));
+
+        for (int i = 0; i <= chainSettings.highCutSlope; ++i)
+            sections.add(highCut[i]);
+
+        std::vector<double> samples(input.getReadPointer(0), input.getReadPointer(0) + input.getNumSamples());
+
+        for (const auto* section : sections)
+        {
+            const auto& c = section->coefficients;
+            double s0 = 0, s1 = 0;
+
+            for (auto& sample : samples)
+            {
+                auto x = sample;
+                auto y = c[0] * x + s0;
+                s0 = c[1] * x - c[3] * y + s1;
+                s1 = c[2] * x - c[4] * y;
+                sample = y;
+            }
+        }
+
+        // Rounding the result to float costs far less than the float rendering itself.
+        juce::AudioBuffer<float> output(1, input.getNumSamples());
+
+        for (int i = 0; i < input.getNumSamples(); ++i)
+            output.setSample(0, i, (float) samples[(size_t) i]);
+
+        return output;
+    }
+
+    static double getError(const juce::AudioBuffer<float>& expected, const juce::AudioBuffer<float>& actual)
+    {
+        return TestHelpers::getRelativeError(expected, actual);
+    }
+};
+
+static SegmentedRendererTests segmentedRendererTests;
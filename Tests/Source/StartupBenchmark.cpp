@@ -0,0 +1,106 @@
+/*
+ ==============================================================================
+
+ Timing of plugin instantiation and editor opening.
+
+ ==============================================================================
+ */
+
+#include "StartupBenchmark.h"
+#include "../../Source/PluginProcessor.h"
+
+namespace
+{
+    struct Stopwatch
+    {
+        juce::int64 start = juce::Time::getHighResolutionTicks();
+
+        double getMicroseconds() const
+        {
+            return juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start) * 1.0e6;
+        }
+    };
+
+    StartupBenchmark::Timing summarise(const std::vector<double>& times)
+    {
+        StartupBenchmark::Timing timing;
+
+        if (times.empty())
+            return timing;
+
+        timing.mean = std::accumulate(times.begin(), times.end(), 0.0) / (double) times.size();
+        timing.max = *std::max_element(times.begin(), times.end());
+        return timing;
+    }
+}
+
+StartupBenchmark::Result StartupBenchmark::run(const Options& options)
+{
+    JUCE_ASSERT_MESSAGE_THREAD
+
+    jassert(options.numInstances > 0);
+
+    auto numEditors = juce::jlimit(0, options.numInstances, options.numEditors);
+
+    std::vector<std::unique_ptr<SimpleeqAudioProcessor>> instances;
+    instances.reserve((size_t) options.numInstances);
+
+    std::vector<double> createTimes, constructTimes, showTimes, destroyTimes;
+
+    for (int i = 0; i < options.numInstances; ++i)
+    {
+        Stopwatch stopwatch;
+        instances.push_back(std::make_unique<SimpleeqAudioProcessor>());
+        createTimes.push_back(stopwatch.getMicroseconds());
+    }
+
+    std::vector<std::unique_ptr<juce::AudioProcessorEditor>> editors;
+
+    for (int i = 0; i < numEditors; ++i)
+    {
+        Stopwatch constructStopwatch;
+        editors.emplace_back(instances[(size_t) i]->createEditorIfNeeded());
+        constructTimes.push_back(constructStopwatch.getMicroseconds());
+
+        Stopwatch showStopwatch;
+        editors.back()->setVisible(true);
+        showTimes.push_back(showStopwatch.getMicroseconds());
+    }
+
+    // editors have to go before their processors
+    editors.clear();
+
+    for (auto& instance : instances)
+    {
+        Stopwatch stopwatch;
+        instance.reset();
+        destroyTimes.push_back(stopwatch.getMicroseconds());
+    }
+
+    Result result;
+    result.numInstances = options.numInstances;
+    result.numEditors = numEditors;
+    result.createInstance = summarise(createTimes);
+    result.constructEditor = summarise(constructTimes);
+    result.showEditor = summarise(showTimes);
+    result.destroyInstance = summarise(destroyTimes);
+    return result;
+}
+
+juce::String StartupBenchmark::Result::toString() const
+{
+    juce::String text;
+
+    auto addLine = [&text](const char* name, int count, const Timing& timing)
+    {
+        text << name << " (" << count << "): mean " << juce::String(timing.mean, 2)
+             << " us, max " << juce::String(timing.max, 2) << " us\n";
+    };
+
+    addLine("create instance ", numInstances, createInstance);
+    addLine("construct editor", numEditors, constructEditor);
+    addLine("show editor     ", numEditors, showEditor);
+    addLine("destroy instance", numInstances, destroyInstance);
+
+    return text;
+}
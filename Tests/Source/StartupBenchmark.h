@@ -0,0 +1,52 @@
+/*
+ ==============================================================================
+
+ Timing of plugin instantiation and editor opening.
+
+ ==============================================================================
+ */
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/*
+ Loading a session with thousands of instances spends its time in the processor constructor (building the
+ parameter layout and the APVTS) and, for every editor the host opens, in the editor constructor and the
+ first time it is shown (when the sliders, attachments and response curve get created, see
+ SimpleeqAudioProcessorEditor::createControlsIfNeeded()).
+
+ This measures each of those steps separately:
+     - creating numInstances processors, all alive at once like in a big session
+     - constructing an editor for the first numEditors of them
+     - making each of those editors visible
+ and reports the mean and max per instance.
+
+ Editors have to be created on the message thread. In the test app that's the main thread, so
+ "simple-eq-tests --benchmarks" can run it directly.
+ */
+struct StartupBenchmark
+{
+    struct Options
+    {
+        int numInstances = 2000;
+        int numEditors = 100;
+    };
+
+    struct Timing
+    {
+        // microseconds per instance
+        double mean = 0, max = 0;
+    };
+
+    struct Result
+    {
+        int numInstances = 0, numEditors = 0;
+
+        Timing createInstance, constructEditor, showEditor, destroyInstance;
+
+        juce::String toString() const;
+    };
+
+    static Result run(const Options& options);
+};
@@ -0,0 +1,118 @@
+/*
+ ==============================================================================
+
+ Worst-case timing of processBlock under automation storms.
+
+ ==============================================================================
+ */
+
+#include "StressHarness.h"
+#include "../../Source/PluginProcessor.h"
+
+namespace
+{
+    double getPercentile(const std::vector<double>& sortedTimes, double percentile)
+    {
+        auto index = static_cast<size_t>(std::ceil(percentile / 100.0 * (double) sortedTimes.size()));
+        return sortedTimes[juce::jlimit<size_t>(0, sortedTimes.size() - 1, index == 0 ? 0 : index - 1)];
+    }
+
+    void prepare(SimpleeqAudioProcessor& processor, double sampleRate, int blockSize)
+    {
+        // what a host does on a sample rate change
+        processor.releaseResources();
+        processor.setRateAndBufferSizeDetails(sampleRate, blockSize);
+        processor.prepareToPlay(sampleRate, blockSize);
+    }
+}
+
+AutomationStressHarness::Result AutomationStressHarness::run(const Options& options)
+{
+    jassert(! options.sampleRates.empty() && options.blockSize > 0 && options.numBlocks > 0 && options.blocksPerSampleRate >= 0);
+
+    SimpleeqAudioProcessor processor;
+    juce::Random random(options.seed);
+
+    juce::AudioBuffer<float> buffer(2, options.blockSize);
+    juce::MidiBuffer midi;
+
+    std::vector<double> times;
+    times.reserve((size_t) options.numBlocks);
+
+    Result result;
+
+    size_t sampleRateIndex = 0;
+    auto sampleRate = options.sampleRates[sampleRateIndex];
+    prepare(processor, sampleRate, options.blockSize);
+
+    for (int block = 0; block < options.numBlocks; ++block)
+    {
+        if (options.blocksPerSampleRate > 0 && block > 0 && block % options.blocksPerSampleRate == 0)
+        {
+            sampleRateIndex = (sampleRateIndex + 1) % options.sampleRates.size();
+            sampleRate = options.sampleRates[sampleRateIndex];
+            prepare(processor, sampleRate, options.blockSize);
+        }
+
+        // every parameter moves, every block. Choices (the slopes) flip between their extremes
+        // so the CutFilter sections get switched on and off each time.
+        for (auto* param : processor.getParameters())
+        {
+            if (dynamic_cast<juce::AudioParameterChoice*>(param) != nullptr)
+                param->setValueNotifyingHost(block % 2 == 0 ? 1.f : 0.f);
+            else
+                param->setValueNotifyingHost(random.nextFloat());
+        }
+
+        for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+            for (int i = 0; i < buffer.getNumSamples(); ++i)
+                buffer.setSample(channel, i, random.nextFloat() * 2.f - 1.f);
+
+        auto start = juce::Time::getHighResolutionTicks();
+        processor.processBlock(buffer, midi);
+        auto end = juce::Time::getHighResolutionTicks();
+
+        auto microseconds = juce::Time::highResolutionTicksToSeconds(end - start) * 1.0e6;
+        times.push_back(microseconds);
+
+        auto deadline = options.deadlineFraction * options.blockSize / sampleRate * 1.0e6;
+
+        if (microseconds > deadline)
+            result.overruns.push_back({ block, sampleRate, microseconds, deadline });
+    }
+
+    result.numBlocks = options.numBlocks;
+    result.mean = std::accumulate(times.begin(), times.end(), 0.0) / (double) times.size();
+
+    std::sort(times.begin(), times.end());
+    result.p50 = getPercentile(times, 50.0);
+    result.p90 = getPercentile(times, 90.0);
+    result.p99 = getPercentile(times, 99.0);
+    result.p999 = getPercentile(times, 99.9);
+    result.p9999 = getPercentile(times, 99.99);
+    result.max = times.back();
+
+    return result;
+}
+
+juce::String AutomationStressHarness::Result::toString() const
+{
+    juce::String text;
+
+    text << "processBlock over " << numBlocks << " blocks (us): "
+         << "mean " << juce::String(mean, 2)
+         << ", p50 " << juce::String(p50, 2)
+         << ", p90 " << juce::String(p90, 2)
+         << ", p99 " << juce::String(p99, 2)
+         << ", p99.9 " << juce::String(p999, 2)
+         << ", p99.99 " << juce::String(p9999, 2)
+         << ", max " << juce::String(max, 2) << "\n";
+
+    text << overruns.size() << " block(s) over the deadline\n";
+
+    for (const auto& overrun : overruns)
+        text << "  block " << overrun.blockIndex << " @ " << juce::String(overrun.sampleRate, 0) << " Hz: "
+             << juce::String(overrun.microseconds, 2) << " us (deadline " << juce::String(overrun.deadlineMicroseconds, 2) << " us)\n";
+
+    return text;
+}
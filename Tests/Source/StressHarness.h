@@ -0,0 +1,67 @@
+/*
+ ==============================================================================
+
+ Worst-case timing of processBlock under automation storms.
+
+ ==============================================================================
+ */
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/*
+ Average CPU numbers hide the blocks that actually cause dropouts. The expensive case for this plugin
+ is a block where every knob moved: updateFilters() redesigns all three bands, and a slope change
+ switches the CutFilter sections on and off on top of that.
+
+ This harness drives a SimpleeqAudioProcessor the way a nasty host session would:
+     - every parameter jumps to a new random value before every block
+     - the slope parameters flip between 12 and 48 dB/Oct every block
+     - the sample rate changes through prepareToPlay() every few thousand blocks (optional)
+ and records how long each processBlock() call took. The report gives the distribution up to p99.99
+ and the max, and lists every block that used more than the configured fraction of its real-time
+ budget (blockSize / sampleRate).
+
+ It doesn't need a host or a GUI. "simple-eq-tests --benchmarks" runs it with the default options.
+ */
+struct AutomationStressHarness
+{
+    struct Options
+    {
+        std::vector<double> sampleRates { 44100.0, 48000.0, 96000.0, 192000.0 };
+        int blockSize = 256;
+        int numBlocks = 40000;
+
+        // prepareToPlay() is called with the next sample rate after this many blocks.
+        // 0 keeps the first sample rate for the whole run.
+        int blocksPerSampleRate = 5000;
+
+        // a block is flagged when it takes longer than this fraction of its duration in real time
+        double deadlineFraction = 0.25;
+
+        juce::int64 seed = 1;
+    };
+
+    struct Overrun
+    {
+        int blockIndex;
+        double sampleRate;
+        double microseconds;
+        double deadlineMicroseconds;
+    };
+
+    struct Result
+    {
+        int numBlocks = 0;
+
+        // processBlock() times, in microseconds
+        double mean = 0, p50 = 0, p90 = 0, p99 = 0, p999 = 0, p9999 = 0, max = 0;
+
+        std::vector<Overrun> overruns;
+
+        juce::String toString() const;
+    };
+
+    static Result run(const Options& options);
+};
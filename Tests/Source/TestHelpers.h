@@ -0,0 +1,61 @@
+/*
+ ==============================================================================
+
+ Settings, signals and comparisons shared by the tests and benchmarks.
+
+ ==============================================================================
+ */
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "../../Source/PluginProcessor.h"
+
+namespace TestHelpers
+{
+    // Direct form settings with the bilinear design, like the parameter defaults. To set up a chain from
+    // them the way the plugin does, use updateChain() from PluginProcessor.h.
+    inline ChainSettings makeChainSettings(float lowCutFreq, Slope lowCutSlope,
+                                           float peakFreq, float peakGainInDecibels, float peakQuality,
+                                           float highCutFreq, Slope highCutSlope)
+    {
+        ChainSettings chainSettings;
+        chainSettings.lowCutFreq = lowCutFreq;
+        chainSettings.lowCutSlope = lowCutSlope;
+        chainSettings.peakFreq = peakFreq;
+        chainSettings.peakGainInDecibels = peakGainInDecibels;
+        chainSettings.peakQuality = peakQuality;
+        chainSettings.highCutFreq = highCutFreq;
+        chainSettings.highCutSlope = highCutSlope;
+        return chainSettings;
+    }
+
+    // white noise between -1 and 1
+    inline juce::AudioBuffer<float> makeNoise(int numChannels, int numSamples, juce::Random& random)
+    {
+        juce::AudioBuffer<float> buffer(numChannels, numSamples);
+
+        for (int channel = 0; channel < numChannels; ++channel)
+            for (int i = 0; i < numSamples; ++i)
+                buffer.setSample(channel, i, random.nextFloat() * 2.f - 1.f);
+
+        return buffer;
+    }
+
+    // The largest difference relative to the loudest expected sample, over all channels.
+    inline double getRelativeError(const juce::AudioBuffer<float>& expected, const juce::AudioBuffer<float>& actual)
+    {
+        jassert(expected.getNumChannels() == actual.getNumChannels() && expected.getNumSamples() == actual.getNumSamples());
+
+        double largestOutput = 0, largestError = 0;
+
+        for (int channel = 0; channel < expected.getNumChannels(); ++channel)
+            for (int i = 0; i < expected.getNumSamples(); ++i)
+            {
+                largestOutput = juce::jmax(largestOutput, (double) std::abs(expected.getSample(channel, i)));
+                largestError = juce::jmax(largestError, (double) std::abs(expected.getSample(channel, i) - actual.getSample(channel, i)));
+            }
+
+        return largestOutput > 0 ? largestError / largestOutput : largestError;
+    }
+}
@@ -0,0 +1,150 @@
+/*
+ ==============================================================================
+
+ Noise floor and cost of the direct form vs. state variable chains.
+
+ ==============================================================================
+ */
+
+#include "TopologyComparison.h"
+
+namespace
+{
+    // the same sections the chains run, designed and processed in double
+    std::vector<juce::dsp::IIR::Filter<double>> makeReferenceFilters(const ChainSettings& chainSettings, double sampleRate)
+    {
+        using Design = juce::dsp::FilterDesign<double>;
+
+        juce::ReferenceCountedArray<juce::dsp::IIR::Coefficients<double>> sections;
+
+        auto lowCut = Design::designIIRHighpassHighOrderButterworthMethod(chainSettings.lowCutFreq, sampleRate, 2 * (chainSettings.lowCutSlope + 1));
+        auto highCut = Design::designIIRLowpassHighOrderButterworthMethod(chainSettings.highCutFreq, sampleRate, 2 * (chainSettings.highCutSlope + 1));
+
+        for (int i = 0; i <= chainSettings.lowCutSlope; ++i)
+            sections.add(lowCut[i]);
+
+        sections.add(juce::dsp::IIR::Coefficients<double>::makePeakFilter(sampleRate,
+                                                                          chainSettings.peakFreq,
+                                                                          chainSettings.peakQuality,
+                                                                          juce::Decibels::decibelsToGain((double) chainSettings.peakGainInDecibels)));
+
+        for (int i = 0; i <= chainSettings.highCutSlope; ++i)
+            sections.add(highCut[i]);
+
+        std::vector<juce::dsp::IIR::Filter<double>> filters((size_t) sections.size());
+
+        for (int i = 0; i < sections.size(); ++i)
+            filters[(size_t) i].coefficients = sections[i];
+
+        return filters;
+    }
+
+    template<typename ChainType>
+    double processInBlocks(ChainType& chain, juce::AudioBuffer<float>& buffer, int blockSize)
+    {
+        auto start = juce::Time::getHighResolutionTicks();
+
+        for (int position = 0; position < buffer.getNumSamples(); position += blockSize)
+        {
+            auto numSamples = juce::jmin(blockSize, buffer.getNumSamples() - position);
+            juce::dsp::AudioBlock<float> block(buffer);
+            auto subBlock = block.getSubBlock((size_t) position, (size_t) numSamples);
+            juce::dsp::ProcessContextReplacing<float> context(subBlock);
+            chain.process(context);
+        }
+
+        auto seconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start);
+        return seconds * 1.0e9 / buffer.getNumSamples();
+    }
+
+    double getErrorDecibels(const juce::AudioBuffer<float>& output, const std::vector<double>& reference)
+    {
+        double errorEnergy = 0, referenceEnergy = 0;
+
+        for (size_t i = 0; i < reference.size(); ++i)
+        {
+            auto error = (double) output.getSample(0, (int) i) - reference[i];
+            errorEnergy += error * error;
+            referenceEnergy += reference[i] * reference[i];
+        }
+
+        return 10.0 * std::log10(errorEnergy / referenceEnergy);
+    }
+}
+
+TopologyComparison::Result TopologyComparison::run(ChainSettings chainSettings, double sampleRate, double seconds, int blockSize)
+{
+    chainSettings.coefficientDesign = CoefficientDesign::Design_Bilinear;
+
+    auto numSamples = static_cast<int>(sampleRate * seconds);
+
+    // noise plus a sine an octave above the low cut, where the direct form struggles most
+    juce::AudioBuffer<float> input(1, numSamples);
+    juce::Random random(1);
+
+    for (int i = 0; i < numSamples; ++i)
+        input.setSample(0, i, 0.3f * (random.nextFloat() * 2.f - 1.f)
+                              + 0.5f * (float) std::sin(juce::MathConstants<double>::twoPi * 2.0 * chainSettings.lowCutFreq * i / sampleRate));
+
+    juce::dsp::ProcessSpec spec;
+    spec.maximumBlockSize = (juce::uint32) blockSize;
+    spec.numChannels = 1;
+    spec.sampleRate = sampleRate;
+
+    // double reference
+    auto referenceFilters = makeReferenceFilters(chainSettings, sampleRate);
+    std::vector<double> reference((size_t) numSamples);
+
+    for (int i = 0; i < numSamples; ++i)
+        reference[(size_t) i] = input.getSample(0, i);
+
+    for (auto& filter : referenceFilters)
+    {
+        filter.prepare(spec);
+
+        for (auto& sample : reference)
+            sample = filter.processSample(sample);
+    }
+
+    Result result;
+
+    // direct form, set up the same way updateFilters() does it
+    {
+        MonoChain chain;
+        chain.prepare(spec);
+
+        updateChain(chain, chainSettings, sampleRate);
+
+        juce::AudioBuffer<float> output(input);
+        result.directFormNanosecondsPerSample = processInBlocks(chain, output, blockSize);
+        result.directFormErrorDecibels = getErrorDecibels(output, reference);
+    }
+
+    // state variable
+    {
+        SvfMonoChain chain;
+        chain.prepare(spec);
+
+        updateCoefficients(chain.get<ChainPositions::Peak>().coefficients, makeSvfPeakFilter(chainSettings, sampleRate));
+        updateCutFilter(chain.get<ChainPositions::LowCut>(), makeSvfLowCutFilter(chainSettings, sampleRate), (Slope) chainSettings.lowCutSlope);
+        updateCutFilter(chain.get<ChainPositions::HighCut>(), makeSvfHighCutFilter(chainSettings, sampleRate), (Slope) chainSettings.highCutSlope);
+
+        juce::AudioBuffer<float> output(input);
+        result.stateVariableNanosecondsPerSample = processInBlocks(chain, output, blockSize);
+        result.stateVariableErrorDecibels = getErrorDecibels(output, reference);
+    }
+
+    return result;
+}
+
+juce::String TopologyComparison::Result::toString() const
+{
+    juce::String text;
+
+    text << "direct form:    error " << juce::String(directFormErrorDecibels, 1) << " dB, "
+         << juce::String(directFormNanosecondsPerSample, 2) << " ns/sample\n"
+         << "state variable: error " << juce::String(stateVariableErrorDecibels, 1) << " dB, "
+         << juce::String(stateVariableNanosecondsPerSample, 2) << " ns/sample\n";
+
+    return text;
+}
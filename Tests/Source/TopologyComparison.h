@@ -0,0 +1,36 @@
+/*
+ ==============================================================================
+
+ Noise floor and cost of the direct form vs. state variable chains.
+
+ ==============================================================================
+ */
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "../../Source/PluginProcessor.h"
+
+/*
+ Runs the same noise through a MonoChain (IIR::Filter, direct form) and an SvfMonoChain with the same
+ settings, and compares both against a double precision direct form reference.
+
+ The error is the energy of (output - reference) relative to the reference, in dB: that's the noise
+ floor the float filters add. The cost is the processing time per sample of the whole chain.
+
+ "simple-eq-tests --benchmarks" runs it for the worst case: a 48 dB/Oct low cut at 20 Hz, at 192 kHz.
+
+ Only the bilinear design is compared, since that's what the double reference is built from.
+ */
+struct TopologyComparison
+{
+    struct Result
+    {
+        double directFormErrorDecibels = 0, stateVariableErrorDecibels = 0;
+        double directFormNanosecondsPerSample = 0, stateVariableNanosecondsPerSample = 0;
+
+        juce::String toString() const;
+    };
+
+    static Result run(ChainSettings chainSettings, double sampleRate, double seconds = 10.0, int blockSize = 512);
+};